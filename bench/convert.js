@@ -0,0 +1,75 @@
+'use strict'
+
+/**
+ * main thread cost of converting native process list to js objects
+ * usage: node bench/convert.js [processes to spawn] [iterations]
+ *
+ * The conversion runs on the main thread right before the callback,
+ * so it's measured as a gap since the last event loop tick.
+ * Snapshots of default fields are converted to objects created from
+ * a template, to objects with properties added one by one and to columns.
+ */
+
+const { spawn } = require('child_process')
+const ps = require('../')
+
+const spawnCount = Number(process.argv[2] || 2000)
+const iterations = Number(process.argv[3] || 20)
+
+const children = []
+for (let i = 0; i < spawnCount; ++i) {
+  children.push(spawn('sleep', ['60'], { stdio: 'ignore' }))
+}
+
+let lastTick = process.hrtime.bigint()
+let ticking = true
+
+function tick () {
+  lastTick = process.hrtime.bigint()
+
+  if (ticking) {
+    setImmediate(tick)
+  }
+}
+
+async function measure (options) {
+  const tasks = await ps.snapshot(options)
+  const gap = Number(process.hrtime.bigint() - lastTick) / 1e6
+  const count = options.columnar ? tasks.pid.length : tasks.length
+
+  return { gap, count }
+}
+
+async function run (title, options) {
+  const gaps = []
+  let count = 0
+
+  for (let i = 0; i < iterations; ++i) {
+    const result = await measure(options)
+
+    gaps.push(result.gap)
+    count = result.count
+  }
+
+  gaps.sort((a, b) => a - b)
+
+  const median = gaps[gaps.length >> 1]
+  const per10k = median / count * 10000
+
+  console.log(`${title}: ${count} processes, median ${median.toFixed(2)} ms, ` +
+    `${per10k.toFixed(2)} ms per 10k processes`)
+}
+
+setTimeout(async () => {
+  tick()
+
+  try {
+    await run('templates', { concurrency: 4 })
+    // undocumented option, the baseline of templates
+    await run('per property', { concurrency: 4, objectTemplates: false })
+    await run('columnar', { concurrency: 4, columnar: true })
+  } finally {
+    ticking = false
+    children.forEach(child => child.kill())
+  }
+}, 1000)
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+/**
+ * generator of fake procfs trees for benchmarks: `stat`, `statm`,
+ * `cmdline`, `exe`, `io`, `smaps_rollup` and one thread in `task`
+ * of every process. Owners are spread over a few uids when it runs
+ * as root, otherwise all processes belong to the current user.
+ *
+ * usage: fixture <root> <count>
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#pragma GCC diagnostic ignored "-Wunused-result"
+
+static const char *const NAMES[] = {
+  "bash", "node", "sshd", "postgres", "nginx", "kworker/0:1",
+  "Web Content", "systemd-journal", "chrome", "python3"
+};
+
+static const uid_t UIDS[] = { 0, 0, 1000, 1000, 1000, 33, 65534 };
+
+template<class T, size_t N>
+static size_t length(const T (&)[N]) {
+  return N;
+}
+
+static void fail(const std::string &path) {
+  perror(path.c_str());
+  exit(1);
+}
+
+static void write_file(const std::string &path, const std::string &data) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+  if (fd == -1 || write(fd, data.data(), data.size()) == -1) {
+    fail(path);
+  }
+
+  close(fd);
+}
+
+static void make_dir(const std::string &path) {
+  if (mkdir(path.c_str(), 0755) == -1 && errno != EEXIST) {
+    fail(path);
+  }
+}
+
+/**
+ * `/proc/$pid/stat` of a process or a thread
+ */
+static std::string stat_line(uint32_t pid, uint32_t ppid, const char *comm,
+                             uint32_t threads) {
+  char buf[512];
+
+  snprintf(buf, sizeof(buf),
+    "%u (%s) S %u %u %u 0 -1 4194560 %u 0 %u 0 %u %u 0 0 20 0 %u 0 %u "
+    "%u %u 18446744073709551615 1 1 0 0 0 0 0 4096 16387 0 0 0 17 %u "
+    "0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+    pid, comm, ppid, pid, pid, pid * 7 % 5000, pid % 40,
+    pid * 13 % 100000, pid * 3 % 20000, threads, pid % 100000 + 1,
+    (pid % 512 + 16) * 1048576, pid % 4096 + 256, pid % 8);
+
+  return buf;
+}
+
+static void make_process(const std::string &root, uint32_t pid) {
+  const char *name = NAMES[pid % length(NAMES)];
+  uint32_t ppid = (pid <= 2) ? 0 : 1 + pid % (pid / 2);
+  uint32_t threads = 1 + pid % 4;
+  std::string dir = root + "/" + std::to_string(pid);
+  std::string exe = std::string("/usr/bin/") + name;
+  char buf[512];
+
+  make_dir(dir);
+  write_file(dir + "/stat", stat_line(pid, ppid, name, threads));
+
+  snprintf(buf, sizeof(buf), "%u %u %u 100 0 %u 0\n",
+    (pid % 512 + 16) * 256, pid % 4096 + 256, pid % 1024, pid % 2048);
+  write_file(dir + "/statm", buf);
+
+  std::string cmdline = exe;
+  cmdline.append(1, '\0').append("--port=" + std::to_string(pid));
+  cmdline.append(1, '\0').append("/var/lib/fixture/data");
+  cmdline.append(1, '\0');
+  write_file(dir + "/cmdline", cmdline);
+
+  snprintf(buf, sizeof(buf),
+    "rchar: %u\nwchar: %u\nsyscr: %u\nsyscw: %u\n"
+    "read_bytes: %u\nwrite_bytes: %u\ncancelled_write_bytes: 0\n",
+    pid * 4096, pid * 1024, pid * 3, pid, pid * 512, pid * 256);
+  write_file(dir + "/io", buf);
+
+  snprintf(buf, sizeof(buf),
+    "00400000-7ffc00000000 ---p 00000000 00:00 0 [rollup]\n"
+    "Rss: %u kB\nPss: %u kB\nShared_Clean: %u kB\nShared_Dirty: 0 kB\n"
+    "Private_Clean: %u kB\nPrivate_Dirty: %u kB\nSwap: %u kB\n",
+    pid % 4096 + 1024, pid % 2048 + 512, pid % 512, pid % 256,
+    pid % 1024, pid % 64);
+  write_file(dir + "/smaps_rollup", buf);
+
+  make_dir(dir + "/task");
+  make_dir(dir + "/task/" + std::to_string(pid));
+  write_file(dir + "/task/" + std::to_string(pid) + "/stat",
+    stat_line(pid, ppid, name, threads));
+
+  unlink((dir + "/exe").c_str());
+
+  if (symlink(exe.c_str(), (dir + "/exe").c_str()) == -1) {
+    fail(dir + "/exe");
+  }
+
+  // the owner is the uid of the process directory
+  if (geteuid() == 0) {
+    chown(dir.c_str(), UIDS[pid % length(UIDS)], 0);
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <root> <count>\n", argv[0]);
+    return 1;
+  }
+
+  std::string root = argv[1];
+  uint32_t count = strtoul(argv[2], NULL, 10);
+
+  make_dir(root);
+  write_file(root + "/stat",
+    "cpu  100 0 100 1000 0 0 0 0 0 0\nbtime 1600000000\nprocesses 1\n");
+
+  for (uint32_t pid = 1; pid <= count; ++pid) {
+    make_process(root, pid);
+  }
+
+  printf("%u processes in %s\n", count, root.c_str());
+  return 0;
+}
@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+/**
+ * microbenchmark of `/proc/$pid/stat` parsers:
+ * the previous `fscanf` chain against `pl::read_procstat`
+ *
+ * usage: procstat [iterations]
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "unix/procstat.h"  // NOLINT(build/include)
+
+#pragma GCC diagnostic ignored "-Wunused-result"
+
+using pl::procstat_t;
+
+/**
+ * the parser used before `pl::read_procstat`
+ */
+static bool fscanf_procstat(const char *path, procstat_t *pstat) {
+  auto fd = fopen(path, "r");
+
+  if (fd == NULL) {
+    return false;
+  }
+
+  fscanf(fd, "%u", &pstat->pid);  // (1)
+  fscanf(fd, " %*s");
+  fscanf(fd, " %*c");
+  fscanf(fd, " %u", &pstat->ppid);  // (4)
+  fscanf(fd, " %*d");
+  fscanf(fd, " %*d");
+  fscanf(fd, " %*d");
+  fscanf(fd, " %*d");
+  fscanf(fd, " %*u");
+  fscanf(fd, " %*u");
+  fscanf(fd, " %*u");
+  fscanf(fd, " %*u");
+  fscanf(fd, " %*u");
+  fscanf(fd, " %lu", &pstat->utime);  // (14)
+  fscanf(fd, " %lu", &pstat->stime);  // (15)
+  fscanf(fd, " %*d");
+  fscanf(fd, " %*d");
+  fscanf(fd, " %d", &pstat->priority);  // (18)
+  fscanf(fd, " %*d");
+  fscanf(fd, " %u", &pstat->threads);  // (20)
+  fscanf(fd, " %*d");
+  fscanf(fd, " %lu", &pstat->uptime);  // (22)
+
+  fclose(fd);
+  return true;
+}
+
+static std::vector<std::string> stat_files() {
+  std::vector<std::string> files;
+  auto dir = opendir("/proc");
+  struct dirent *entry;
+
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] >= '1' && entry->d_name[0] <= '9') {
+      files.push_back(std::string("/proc/") + entry->d_name + "/stat");
+    }
+  }
+
+  closedir(dir);
+  return files;
+}
+
+static std::vector<std::string> contents(
+    const std::vector<std::string> &files) {
+  std::vector<std::string> data;
+
+  for (auto &file : files) {
+    char buf[1024];
+    int fd = open(file.c_str(), O_RDONLY);
+    ssize_t size = (fd == -1) ? -1 : read(fd, buf, sizeof(buf));
+
+    if (fd != -1) {
+      close(fd);
+    }
+
+    data.push_back(size > 0 ? std::string(buf, size) : std::string());
+  }
+
+  return data;
+}
+
+template<class Fn>
+static double measure(const char *title, size_t processes, int iterations,
+                      Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < iterations; ++i) {
+    fn();
+  }
+
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  double per_process = ns / iterations / processes;
+
+  printf("%-24s %10.0f ns/process\n", title, per_process);
+  return per_process;
+}
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 200;
+  auto files = stat_files();
+  auto data = contents(files);
+  size_t mismatches = 0;
+
+  for (size_t i = 0; i < files.size(); ++i) {
+    procstat_t a, b;
+
+    if (!fscanf_procstat(files[i].c_str(), &a) ||
+        !pl::parse_procstat(data[i].data(), data[i].size(), &b)) {
+      continue;
+    }
+
+    // `%*s` of the old parser breaks on `comm` with spaces
+    if (a.pid != b.pid || a.ppid != b.ppid || a.threads != b.threads) {
+      printf("mismatch: %s (%s)\n", files[i].c_str(), b.comm);
+      ++mismatches;
+    }
+  }
+
+  printf("%zu processes, %d iterations, %zu mismatches\n\n",
+    files.size(), iterations, mismatches);
+
+  procstat_t pstat;
+
+  double before = measure("fscanf", files.size(), iterations,
+      [&files, &pstat]() {
+    for (auto &file : files) {
+      fscanf_procstat(file.c_str(), &pstat);
+    }
+  });
+
+  double after = measure("read_procstat", files.size(), iterations,
+      [&files, &pstat]() {
+    for (auto &file : files) {
+      pl::read_procstat(AT_FDCWD, file.c_str(), &pstat);
+    }
+  });
+
+  measure("parse_procstat (no io)", files.size(), iterations,
+      [&data, &pstat]() {
+    for (auto &content : data) {
+      pl::parse_procstat(content.data(), content.size(), &pstat);
+    }
+  });
+
+  printf("\nspeedup: %.2fx\n", before / after);
+  return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+/**
+ * scaling benchmark of `pl::list` over procfs trees of `fixture`:
+ * the cost of every field on top of `pid` and the throughput
+ * of the default and all fields with the number of heap allocations
+ * made by one snapshot, and of the default fields with `cache_size`
+ *
+ * usage: scan [-c concurrency] <root>...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <new>
+#include <string>
+
+#include "tasklist.h"  // NOLINT(build/include)
+
+using pl::process_fields;
+
+static std::atomic<size_t> allocations(0);
+
+void *operator new(size_t size) {
+  ++allocations;
+  void *data = malloc(size ? size : 1);
+
+  if (data == NULL) {
+    throw std::bad_alloc();
+  }
+
+  return data;
+}
+
+void operator delete(void *data) noexcept {
+  free(data);
+}
+
+struct field {
+  const char *name;
+  bool process_fields::*member;
+  // one of `defaultFields` of index.js
+  bool standard;
+};
+
+static const field FIELDS[] = {
+  { "name", &process_fields::name, true },
+  { "ppid", &process_fields::ppid, true },
+  { "path", &process_fields::path, true },
+  { "threads", &process_fields::threads, true },
+  { "owner", &process_fields::owner, true },
+  { "uid", &process_fields::uid, false },
+  { "priority", &process_fields::priority, true },
+  { "cmdline", &process_fields::cmdline, true },
+  { "starttime", &process_fields::starttime, true },
+  { "vmem", &process_fields::vmem, true },
+  { "pmem", &process_fields::pmem, true },
+  { "cpu", &process_fields::cpu, true },
+  { "utime", &process_fields::utime, true },
+  { "stime", &process_fields::stime, true },
+  { "pss", &process_fields::pss, false },
+  { "uss", &process_fields::uss, false },
+  { "swap", &process_fields::swap, false },
+  { "shared", &process_fields::shared, false },
+  { "readBytes", &process_fields::read_bytes, false },
+  { "writeBytes", &process_fields::write_bytes, false },
+  { "rchar", &process_fields::rchar, false },
+  { "wchar", &process_fields::wchar, false },
+  { "syscr", &process_fields::syscr, false },
+  { "syscw", &process_fields::syscw, false },
+  { "tasks", &process_fields::tasks, false }
+};
+
+static process_fields none() {
+  process_fields fields = process_fields();
+  fields.pid = true;
+
+  return fields;
+}
+
+/**
+ * best time of a few runs in ns per process
+ */
+static double measure(const process_fields &fields,
+                      const pl::list_options &options, size_t *count) {
+  double best = 0;
+
+  for (int i = 0; i < 5; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    size_t size = pl::list(fields, options).size();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+
+    *count = size;
+    best = (i == 0) ? ns : std::min(best, ns);
+  }
+
+  return (*count == 0) ? 0 : best / *count;
+}
+
+/**
+ * heap allocations of one snapshot
+ */
+static size_t count_allocations(const process_fields &fields,
+                                const pl::list_options &options) {
+  size_t before = allocations;
+  pl::list(fields, options);
+
+  return allocations - before;
+}
+
+static void bench(const char *root, uint32_t concurrency) {
+  pl::list_options options;
+  options.procfs = root;
+  options.concurrency = concurrency;
+
+  // warm up dentry and inode caches of the tree
+  pl::list(none(), options);
+
+  size_t count;
+  double base = measure(none(), options, &count);
+
+  printf("%s: %zu processes, concurrency %u\n\n", root, count, concurrency);
+  printf("%-12s %10.0f ns/process\n", "pid", base);
+
+  process_fields defaults = none();
+  process_fields all = none();
+
+  for (const field &f : FIELDS) {
+    process_fields fields = none();
+    fields.*f.member = true;
+    all.*f.member = true;
+
+    if (f.standard) {
+      defaults.*f.member = true;
+    }
+
+    double ns = measure(fields, options, &count);
+    printf("%-12s %+10.0f ns/process\n", f.name, ns - base);
+  }
+
+  double ns = measure(defaults, options, &count);
+  printf("\n%-12s %10.0f processes/s %10zu allocations\n", "default",
+    1e9 / ns, count_allocations(defaults, options));
+
+  ns = measure(all, options, &count);
+  printf("%-12s %10.0f processes/s %10zu allocations\n", "all",
+    1e9 / ns, count_allocations(all, options));
+
+  // path and cmdline are read by the first run only
+  pl::list_options cached = options;
+  cached.cache_size = static_cast<uint32_t>(count);
+
+  ns = measure(defaults, cached, &count);
+  printf("%-12s %10.0f processes/s %10zu allocations\n\n", "cached",
+    1e9 / ns, count_allocations(defaults, cached));
+}
+
+int main(int argc, char **argv) {
+  uint32_t concurrency = 1;
+  int i = 1;
+
+  if (argc > 2 && !strcmp(argv[1], "-c")) {
+    concurrency = std::max(1, atoi(argv[2]));
+    i = 3;
+  }
+
+  if (i == argc) {
+    fprintf(stderr, "usage: %s [-c concurrency] <root>...\n", argv[0]);
+    return 1;
+  }
+
+  for (; i < argc; ++i) {
+    bench(argv[i], concurrency);
+  }
+
+  return 0;
+}
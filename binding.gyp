@@ -4,6 +4,21 @@
     "sources": [
       "src/main.cpp"
       , "src/snapshot.cpp"
+      , "src/columns.cpp"
+      , "src/sampler.cpp"
+      , "src/sampler_wrap.cpp"
+      , "src/monitor.cpp"
+      , "src/shared_table.cpp"
+      , "src/differ.cpp"
+      , "src/differ_wrap.cpp"
+      , "src/filter.cpp"
+      , "src/tree.cpp"
+      , "src/tree_wrap.cpp"
+      , "src/stream_wrap.cpp"
+      , "src/executor.cpp"
+      , "src/stats.cpp"
+      , "src/arena.cpp"
+      , "src/metadata.cpp"
     ],
     "include_dirs":["src", "<!(node -e \"require('nan')\")"],
     "conditions": [
@@ -24,14 +39,19 @@
         }
       }],["OS!='mac' and OS!='win'", {
         "sources": [
-          "src/unix/tasklist.cpp"
+          "src/unix/tasklist.cpp",
+          "src/unix/procstat.cpp",
+          "src/unix/watcher.cpp",
+          "src/unix/watcher_wrap.cpp"
         ],
         "cflags_cc!": ["-fno-rtti", "-fno-exceptions"],
         "cflags_cc+": [
           "-fexceptions",
           "-std=c++0x",
-          "-frtti"
-        ]
+          "-frtti",
+          "-pthread"
+        ],
+        "ldflags": ["-pthread"]
       }]
     ]
   }]
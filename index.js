@@ -1,9 +1,12 @@
 'use strict'
 
+const EventEmitter = require('events')
 const ps = require('bindings')('processlist')
 const then = require('pify')
+const { SharedTable } = require('./shared')
 
 const es6snapshot = then(ps.snapshot)
+const es6tree = then(ps.tree)
 
 const allowedFields = Object.freeze([
   'name',
@@ -12,6 +15,7 @@ const allowedFields = Object.freeze([
   'path',
   'threads',
   'owner',
+  'uid',
   'priority',
   'cmdline',
   'starttime',
@@ -19,29 +23,122 @@ const allowedFields = Object.freeze([
   'pmem',
   'cpu',
   'utime',
-  'stime'
+  'stime',
+  'pss',
+  'uss',
+  'swap',
+  'shared',
+  'readBytes',
+  'writeBytes',
+  'rchar',
+  'wchar',
+  'syscr',
+  'syscw'
 ])
 
-const defaultFields = {
-  name: true,
-  pid: true,
-  ppid: true,
-  path: true,
-  threads: true,
-  owner: true,
-  priority: true,
-  cmdline: true,
-  starttime: true,
-  vmem: true,
-  pmem: true,
-  cpu: true,
-  utime: true,
-  stime: true
-}
+const numericFields = Object.freeze([
+  'threads',
+  'priority',
+  'vmem',
+  'pmem',
+  'cpu',
+  'utime',
+  'stime',
+  'pss',
+  'uss',
+  'swap',
+  'shared',
+  'readBytes',
+  'writeBytes',
+  'rchar',
+  'wchar',
+  'syscr',
+  'syscw'
+])
 
-module.exports = {
-  snapshot,
-  allowedFields
+/**
+ * cost of every field on Linux: `low` fields share a few small reads,
+ * `high` ones make the kernel walk all memory mappings of the process
+ */
+const fieldCost = Object.freeze({
+  pid: Object.freeze({ cost: 'low', source: '/proc' }),
+  ppid: Object.freeze({ cost: 'low', source: 'stat' }),
+  name: Object.freeze({ cost: 'low', source: 'stat' }),
+  path: Object.freeze({ cost: 'low', source: 'exe' }),
+  threads: Object.freeze({ cost: 'low', source: 'stat' }),
+  owner: Object.freeze({ cost: 'medium', source: 'user database, cached' }),
+  uid: Object.freeze({ cost: 'low', source: 'fstatat' }),
+  priority: Object.freeze({ cost: 'low', source: 'stat' }),
+  cmdline: Object.freeze({ cost: 'medium', source: 'cmdline' }),
+  starttime: Object.freeze({ cost: 'low', source: 'stat' }),
+  vmem: Object.freeze({ cost: 'low', source: 'statm' }),
+  pmem: Object.freeze({ cost: 'low', source: 'statm' }),
+  cpu: Object.freeze({ cost: 'low', source: 'stat' }),
+  utime: Object.freeze({ cost: 'low', source: 'stat' }),
+  stime: Object.freeze({ cost: 'low', source: 'stat' }),
+  pss: Object.freeze({ cost: 'high', source: 'smaps_rollup' }),
+  uss: Object.freeze({ cost: 'high', source: 'smaps_rollup' }),
+  swap: Object.freeze({ cost: 'high', source: 'smaps_rollup' }),
+  shared: Object.freeze({ cost: 'high', source: 'smaps_rollup' }),
+  readBytes: Object.freeze({ cost: 'medium', source: 'io' }),
+  writeBytes: Object.freeze({ cost: 'medium', source: 'io' }),
+  rchar: Object.freeze({ cost: 'medium', source: 'io' }),
+  wchar: Object.freeze({ cost: 'medium', source: 'io' }),
+  syscr: Object.freeze({ cost: 'medium', source: 'io' }),
+  syscw: Object.freeze({ cost: 'medium', source: 'io' })
+})
+
+const numericModes = Object.freeze([
+  'string',
+  'number',
+  'bigint'
+])
+
+const threadModes = Object.freeze([
+  'count',
+  'detail'
+])
+
+const executors = Object.freeze([
+  'pool',
+  'dedicated'
+])
+
+/**
+ * fields read when none is requested, the ones added later
+ * are opt-in, so a plain `snapshot()` reads the same files as before
+ */
+const defaultFields = Object.freeze([
+  'name',
+  'pid',
+  'ppid',
+  'path',
+  'threads',
+  'owner',
+  'priority',
+  'cmdline',
+  'starttime',
+  'vmem',
+  'pmem',
+  'cpu',
+  'utime',
+  'stime'
+])
+
+const defaultOptions = {
+  concurrency: 1,
+  ownerCacheTtl: 60000,
+  metadataCache: 0,
+  columnar: false,
+  numeric: 'string',
+  filter: null,
+  roots: false,
+  batchSize: 256,
+  idleTimeout: 10000,
+  threads: 'count',
+  procfs: '/proc',
+  executor: 'pool',
+  stats: false
 }
 
 /**
@@ -52,17 +149,411 @@ module.exports = {
  * @param {bool} opts.name
  * @param {bool} opts.path
  * @param {bool} opts.owner
+ * @param {bool} opts.uid
  * @param {bool} opts.threads
  * @param {bool} opts.priority
  * @param {bool} opts.cmdline
+ * @param {Object} [options] the last argument
+ * @param {Number} options.concurrency number of threads to read `/proc`
+ * @param {Number} options.ownerCacheTtl how long owner names are cached, ms
+ * @param {Number} options.metadataCache max number of processes whose `path`
+ * and `cmdline` are kept until `execve`, 0 disables the cache, Linux only
+ * @param {bool} options.columnar return object of typed arrays
+ * @param {String} options.numeric type of 64-bit fields vmem, pmem, utime,
+ * stime, pss, uss, swap, shared and io counters: 'string', 'number' or 'bigint'
+ * @param {Object} options.filter return only matching processes
+ * @param {Array} options.filter.pids
+ * @param {Number} options.filter.ppid
+ * @param {Number} options.filter.uid
+ * @param {String} options.filter.owner
+ * @param {String} options.filter.name glob pattern with `*` and `?`
+ * @param {String} options.threads 'detail' adds `tasks` array of threads
+ * `{ tid, name, state, starttime, cpu, utime, stime }`, Linux only,
+ * it can't be combined with `columnar`
+ * @param {String} options.procfs root of procfs, Linux only
+ * @param {String} options.executor 'pool' to read on the libuv thread pool,
+ * 'dedicated' to read on the own thread of the addon
+ * @param {bool} options.stats attach non-enumerable `stats` of the scan
+ * to the result of `snapshot()`, `snapshotSync()`, `tree()`, `diff()`,
+ * `sample()` and `watcher.snapshot()`: `{ processes, skipped, vanished, phases }`, see `getStats()`.
+ * Processes exited during the scan are dropped, `vanished` is their number
  */
 function snapshot (args) {
+  const [opts, options] = parseArgs(Array.from(arguments))
+
+  return es6snapshot(opts, options)
+}
+
+/**
+ * get process list on the calling thread, accepts the same arguments
+ * as `snapshot()`. It blocks the event loop, so it's meant for small
+ * filtered queries, e.g. `snapshotSync('pid', 'pmem', { filter: { pids } })`
+ * @returns {Array|Object}
+ */
+function snapshotSync () {
+  const [opts, options] = parseArgs(Array.from(arguments))
+
+  return ps.snapshotSync(opts, options)
+}
+
+/**
+ * cumulative stats of all snapshots made with `stats: true`:
+ * `{ processes, skipped, vanished, snapshots, phases, histograms }`.
+ * Every phase has `{ calls, wall, cpu, syscalls, bytes }`, times are in ns.
+ * Histograms count snapshots by the wall time of the phase,
+ * bucket `i` is `[2^(i-1), 2^i)` microseconds.
+ * `metadataCache` has `{ size, hits, misses, invalidations, evictions }`
+ * of the `metadataCache` option, they are counted without `stats` as well
+ * @returns {Object}
+ */
+function getStats () {
+  return ps.getStats()
+}
+
+/**
+ * get process tree in depth-first order, every process has `depth`
+ * and `subtree` totals of itself and its descendants:
+ * `{ count, threads, vmem, pmem, cpu }`.
+ * Accepts the same arguments as `snapshot()` except `columnar`,
+ * `pid`, `ppid`, `threads`, `vmem`, `pmem` and `cpu` are always read
+ * @param {bool} options.roots return only roots with totals of their trees
+ */
+function tree () {
+  const [opts, options] = parseArgs(Array.from(arguments))
+
+  if (typeof options.roots !== 'boolean') {
+    throw new Error('Option "roots" should be a boolean')
+  }
+
+  return es6tree(opts, options)
+}
+
+/**
+ * read process list in batches, accepts the same arguments as `snapshot()`
+ * except `columnar` and `stats`
+ * @param {Number} options.batchSize max number of processes in the batch
+ * @param {Number} options.idleTimeout how long the reader waits for
+ * the consumer in ms, then the stream fails
+ * @returns {AsyncIterator} iterator of arrays of processes
+ */
+function stream () {
+  const [opts, options] = parseArgs(Array.from(arguments))
+
+  if (!Number.isInteger(options.batchSize) || options.batchSize < 1) {
+    throw new Error('Option "batchSize" should be a positive integer')
+  }
+
+  if (!Number.isInteger(options.idleTimeout) || options.idleTimeout < 1 ||
+      options.idleTimeout > 0xFFFFFFFF) {
+    throw new Error('Option "idleTimeout" should be a positive 32-bit integer')
+  }
+
+  if (options.stats) {
+    throw new Error('Option "stats" isn\'t supported by the stream')
+  }
+
+  return new BatchIterator(opts, options)
+}
+
+/**
+ * async iterator of batches, the native reader waits
+ * while the batches aren't consumed
+ */
+class BatchIterator {
+  constructor (opts, options) {
+    this._batches = []
+    this._waiting = null
+    this._done = false
+    this._error = null
+
+    this._reader = new ps.Stream()
+    this._reader.read(opts, options,
+      batch => this._push(batch),
+      error => this._end(error)
+    )
+  }
+
+  [Symbol.asyncIterator] () {
+    return this
+  }
+
+  next () {
+    if (this._batches.length) {
+      this._reader.ack()
+      return Promise.resolve({ value: this._batches.shift(), done: false })
+    }
+
+    if (this._error) {
+      const error = this._error
+      this._error = null
+      return Promise.reject(error)
+    }
+
+    if (this._done) {
+      return Promise.resolve({ value: undefined, done: true })
+    }
+
+    return new Promise((resolve, reject) => {
+      this._waiting = { resolve, reject }
+    })
+  }
+
+  /**
+   * stop reading, it's called by `for await` on `break`
+   */
+  return () {
+    this._reader.cancel()
+    this._batches = []
+    this._done = true
+
+    return Promise.resolve({ value: undefined, done: true })
+  }
+
+  _push (batch) {
+    if (!this._waiting) {
+      this._batches.push(batch)
+      return
+    }
+
+    const { resolve } = this._waiting
+    this._waiting = null
+    this._reader.ack()
+
+    resolve({ value: batch, done: false })
+  }
+
+  _end (error) {
+    this._done = true
+    this._error = error || null
+
+    if (!this._waiting) {
+      return
+    }
+
+    const { resolve, reject } = this._waiting
+    this._waiting = null
+    this._error = null
+
+    if (error) {
+      reject(error)
+    } else {
+      resolve({ value: undefined, done: true })
+    }
+  }
+}
+
+/**
+ * read string of the columnar snapshot
+ * @param {Object} column string column `{ offsets, data }`
+ * @param {Number} index
+ * @returns {String}
+ */
+function columnString (column, index) {
+  return column.data.toString('utf8', column.offsets[index], column.offsets[index + 1])
+}
+
+/**
+ * keeps cpu time of processes between calls,
+ * so `cpu` of `sample()` is the usage over the last interval
+ * normalized by the number of cores
+ */
+class Sampler {
+  constructor () {
+    const sampler = new ps.Sampler()
+
+    this._native = sampler
+    this._sample = then(sampler.sample.bind(sampler))
+  }
+
+  /**
+   * get process list, accepts the same arguments as `snapshot()`
+   */
+  sample () {
+    const [opts, options] = parseArgs(Array.from(arguments))
+
+    return this._sample(opts, options)
+  }
+
+  /**
+   * sample processes on the background thread, accepts the same arguments
+   * as `snapshot()`, a running sampler is restarted
+   * @param {Number} options.interval period of scans in ms, it grows
+   * when the scan takes more than a half of it
+   */
+  start () {
+    const [opts, options] = parseArgs(Array.from(arguments))
+    const interval = options.interval === undefined ? 1000 : options.interval
+
+    if (!Number.isInteger(interval) || interval < 1) {
+      throw new Error('Option "interval" should be a positive integer')
+    }
+
+    this._native.start(opts, options, interval)
+  }
+
+  /**
+   * the newest list of the background thread, `null` before the first one
+   * @returns {Array|Object|null}
+   */
+  getLatest () {
+    return this._native.latest()
+  }
+
+  stop () {
+    this._native.stop()
+  }
+
+  /**
+   * publish every background sample to a new `SharedArrayBuffer` too,
+   * pass it to worker threads and read it with `SharedTable`
+   * @param {Object} [options]
+   * @param {Number} options.capacity max number of processes
+   * @param {Number} options.heapSize bytes for strings of all processes
+   * @returns {SharedArrayBuffer}
+   */
+  share (options) {
+    const { capacity = 4096, heapSize = 1048576 } = options || {}
+
+    if (!Number.isInteger(capacity) || capacity < 1 || capacity > 1048576) {
+      throw new Error('Option "capacity" should be an integer in 1..1048576')
+    }
+
+    if (!Number.isInteger(heapSize) || heapSize < 0 || heapSize > 0x7fffffff) {
+      throw new Error('Option "heapSize" should be a non-negative 32-bit integer')
+    }
+
+    const buffer = new SharedArrayBuffer(SharedTable.bytes(capacity, heapSize))
+    this._native.share(buffer, capacity, heapSize)
+
+    return buffer
+  }
+}
+
+/**
+ * keeps the previous process list and returns only the difference,
+ * processes are identified by `pid` and `starttime`
+ */
+class Differ {
+  /**
+   * @param {Object} [thresholds] minimal change of numeric fields
+   * to report the process as changed, e.g. `{ pmem: 1048576 }`
+   */
+  constructor (thresholds) {
+    thresholds = Object.assign({}, thresholds)
+
+    for (const field of Object.keys(thresholds)) {
+      if (numericFields.indexOf(field) === -1) {
+        throw new Error(`Threshold of unknown numeric field "${field}"`)
+      }
+    }
+
+    const differ = new ps.Differ(thresholds)
+
+    this._diff = then(differ.diff.bind(differ))
+  }
+
+  /**
+   * get `{ added, removed, changed }` processes since the previous call,
+   * accepts the same arguments as `snapshot()`
+   */
+  diff () {
+    const [opts, options] = parseArgs(Array.from(arguments))
+
+    return this._diff(opts, options)
+  }
+}
+
+/**
+ * keeps the process table up to date with fork, exec, exit and uid change
+ * events of the netlink proc connector, Linux only, requires CAP_NET_ADMIN.
+ * Emits `fork` `{ pid, ppid }`, `exec` `{ pid }`, `exit` `{ pid, code, signal }`,
+ * `uid` `{ pid, uid }` and `error`
+ */
+class Watcher extends EventEmitter {
+  constructor () {
+    super()
+
+    if (!ps.Watcher) {
+      throw new Error('Watcher is supported on Linux only')
+    }
+
+    const watcher = new ps.Watcher((type, pid, value) => this._event(type, pid, value))
+
+    this._watcher = watcher
+    this._snapshot = then(watcher.snapshot.bind(watcher))
+    this._closed = false
+  }
+
+  /**
+   * get process list from the table, accepts the same arguments as `snapshot()`
+   * except `procfs`
+   */
+  snapshot () {
+    if (this._closed) {
+      return Promise.reject(new Error('Watcher is closed'))
+    }
+
+    const [opts, options] = parseArgs(Array.from(arguments))
+
+    // the table is read from `/proc` of the kernel sending events
+    if (options.procfs !== defaultOptions.procfs) {
+      throw new Error('Option "procfs" isn\'t supported by the watcher')
+    }
+
+    return this._snapshot(opts, options)
+  }
+
+  /**
+   * stop watching
+   */
+  close () {
+    this._closed = true
+    this._watcher.close()
+  }
+
+  /**
+   * don't keep the event loop alive
+   */
+  unref () {
+    this._watcher.unref()
+    return this
+  }
+
+  _event (type, pid, value) {
+    switch (type) {
+      case 'fork':
+        this.emit(type, { pid, ppid: value })
+        break
+      case 'exec':
+        this.emit(type, { pid })
+        break
+      case 'exit':
+        this.emit(type, { pid, code: (value >> 8) & 0xff, signal: value & 0x7f })
+        break
+      case 'uid':
+        this.emit(type, { pid, uid: value })
+        break
+      case 'error':
+        this.emit(type, new Error(pid))
+        break
+    }
+  }
+}
+
+/**
+ * convert arguments to requested fields and options
+ * @param {Array} args
+ * @returns {Array}
+ */
+function parseArgs (args) {
   let opts = {}
 
-  args = Array.isArray(args) ? args : Array.from(arguments)
+  args = Array.isArray(args[0]) ? args[0].concat(args.slice(1)) : args
+
+  const options = parseOptions(args)
 
   if (!args.length) {
-    opts = defaultFields
+    args = defaultFields
   }
 
   for (let i = 0; i < args.length; ++i) {
@@ -73,5 +564,128 @@ function snapshot (args) {
     opts[args[i]] = true
   }
 
-  return es6snapshot(opts)
+  if (options.threads === 'detail') {
+    opts.tasks = true
+  }
+
+  return [opts, options]
+}
+
+/**
+ * pop options object from the list of arguments
+ * @param {Array} args
+ * @returns {Object}
+ */
+function parseOptions (args) {
+  const last = args[args.length - 1]
+
+  if (last === null || typeof last !== 'object') {
+    return defaultOptions
+  }
+
+  args.pop()
+
+  const options = Object.assign({}, defaultOptions, last)
+
+  if (!Number.isInteger(options.concurrency) || options.concurrency < 1) {
+    throw new Error('Option "concurrency" should be a positive integer')
+  }
+
+  if (!Number.isInteger(options.ownerCacheTtl) || options.ownerCacheTtl < 0) {
+    throw new Error('Option "ownerCacheTtl" should be a non-negative integer')
+  }
+
+  if (!Number.isInteger(options.metadataCache) || options.metadataCache < 0) {
+    throw new Error('Option "metadataCache" should be a non-negative integer')
+  }
+
+  if (numericModes.indexOf(options.numeric) === -1) {
+    throw new Error(`Option "numeric" should be one of: ${numericModes.join(', ')}`)
+  }
+
+  if (options.numeric === 'bigint' && typeof BigInt === 'undefined') {
+    throw new Error('BigInt is not supported')
+  }
+
+  if (threadModes.indexOf(options.threads) === -1) {
+    throw new Error(`Option "threads" should be one of: ${threadModes.join(', ')}`)
+  }
+
+  if (options.threads === 'detail' && options.columnar) {
+    throw new TypeError('Option "threads: \'detail\'" isn\'t supported by the columnar snapshot')
+  }
+
+  if (executors.indexOf(options.executor) === -1) {
+    throw new Error(`Option "executor" should be one of: ${executors.join(', ')}`)
+  }
+
+  if (typeof options.stats !== 'boolean') {
+    throw new Error('Option "stats" should be a boolean')
+  }
+
+  if (typeof options.procfs !== 'string' || options.procfs === '') {
+    throw new Error('Option "procfs" should be a non-empty string')
+  }
+
+  if (options.filter !== null) {
+    checkFilter(options.filter)
+  }
+
+  return options
+}
+
+/**
+ * validate `filter` option
+ * @param {Object} filter
+ */
+function checkFilter (filter) {
+  if (typeof filter !== 'object') {
+    throw new Error('Option "filter" should be an object')
+  }
+
+  // ids are 32-bit, larger values would wrap to another id
+  const isId = value => Number.isInteger(value) && value >= 0 && value <= 0xFFFFFFFF
+
+  for (const key of Object.keys(filter)) {
+    const value = filter[key]
+
+    switch (key) {
+      case 'pids':
+        // an empty list would mean any process
+        if (!Array.isArray(value) || !value.length || !value.every(isId)) {
+          throw new Error('Filter "pids" should be a non-empty array of non-negative 32-bit integers')
+        }
+        break
+      case 'ppid':
+      case 'uid':
+        if (!isId(value)) {
+          throw new Error(`Filter "${key}" should be a non-negative 32-bit integer`)
+        }
+        break
+      case 'owner':
+      case 'name':
+        if (typeof value !== 'string') {
+          throw new Error(`Filter "${key}" should be a string`)
+        }
+        break
+      default:
+        throw new Error(`Unknown filter "${key}"`)
+    }
+  }
+}
+
+module.exports = {
+  snapshot,
+  snapshotSync,
+  getStats,
+  tree,
+  stream,
+  Sampler,
+  Differ,
+  Watcher,
+  SharedTable,
+  columnString,
+  allowedFields,
+  defaultFields,
+  fieldCost
 }
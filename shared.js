@@ -0,0 +1,284 @@
+'use strict'
+
+/**
+ * reader of the process table published by `sampler.share()`,
+ * it doesn't load the addon, so it can be required in worker threads.
+ * The layout is described in `src/shared_table.h`
+ */
+
+const MAGIC = 0x504c5354
+const VERSION = 1
+const HEADER_SIZE = 64
+
+// words of the header
+const SEQUENCE = 2
+const GENERATION = 3
+const CAPACITY = 4
+const HEAP_SIZE = 5
+const LENGTH = 6
+const FIELDS = 8
+const FLAGS = 9
+const TIMESTAMP = 5 // index of `Float64Array`
+
+// attempts of `read()` without sleeping, then it sleeps 1 ms between them
+const SPIN_ATTEMPTS = 64
+// ms `read()` waits for a consistent table before throwing
+const READ_TIMEOUT = 1000
+
+const TRUNCATED_ROWS = 1
+const TRUNCATED_STRINGS = 2
+
+const wideColumns = Object.freeze([
+  'starttime',
+  'cpu',
+  'vmem',
+  'pmem',
+  'utime',
+  'stime',
+  'pss',
+  'uss',
+  'swap',
+  'shared',
+  'readBytes',
+  'writeBytes',
+  'rchar',
+  'wchar',
+  'syscr',
+  'syscw'
+])
+
+const narrowColumns = Object.freeze([
+  'pid',
+  'ppid',
+  'uid',
+  'threads',
+  'priority'
+])
+
+const stringColumns = Object.freeze([
+  'name',
+  'path',
+  'cmdline',
+  'owner'
+])
+
+// bits of the mask of fields
+const maskFields = Object.freeze(
+  narrowColumns.concat(wideColumns, stringColumns)
+)
+
+// keys of process objects in the order of `snapshot()`
+const objectFields = Object.freeze([
+  'name',
+  'pid',
+  'ppid',
+  'path',
+  'threads',
+  'owner',
+  'uid',
+  'priority',
+  'cmdline',
+  'starttime',
+  'vmem',
+  'pmem',
+  'cpu',
+  'utime',
+  'stime',
+  'pss',
+  'uss',
+  'swap',
+  'shared',
+  'readBytes',
+  'writeBytes',
+  'rchar',
+  'wchar',
+  'syscr',
+  'syscw'
+])
+
+// nobody notifies it, `Atomics.wait` on it is a sleep
+const sleeper = new Int32Array(new SharedArrayBuffer(4))
+
+class SharedTable {
+  /**
+   * size of the buffer for the table
+   * @param {Number} capacity max number of processes
+   * @param {Number} heapSize bytes for strings
+   * @returns {Number}
+   */
+  static bytes (capacity, heapSize) {
+    const rowSize = wideColumns.length * 8 +
+      (narrowColumns.length + stringColumns.length * 2) * 4
+
+    return HEADER_SIZE + capacity * rowSize + heapSize
+  }
+
+  /**
+   * @param {SharedArrayBuffer} buffer returned by `sampler.share()`
+   */
+  constructor (buffer) {
+    const header = new Int32Array(buffer, 0, HEADER_SIZE / 4)
+
+    if (header[0] !== MAGIC || header[1] !== VERSION) {
+      throw new Error('Unknown layout of the shared table')
+    }
+
+    const capacity = header[CAPACITY]
+    const heapSize = header[HEAP_SIZE]
+    let offset = HEADER_SIZE
+
+    this.buffer = buffer
+    this.capacity = capacity
+    this._header = header
+    this._timestamp = new Float64Array(buffer, 0, HEADER_SIZE / 8)
+    this._columns = {}
+    this._strings = {}
+
+    for (const field of wideColumns) {
+      this._columns[field] = new Float64Array(buffer, offset, capacity)
+      offset += capacity * 8
+    }
+
+    for (const field of narrowColumns) {
+      const Type = field === 'priority' ? Int32Array : Uint32Array
+
+      this._columns[field] = new Type(buffer, offset, capacity)
+      offset += capacity * 4
+    }
+
+    for (const field of stringColumns) {
+      this._strings[field] = {
+        offsets: new Uint32Array(buffer, offset, capacity),
+        lengths: new Uint32Array(buffer, offset + capacity * 4, capacity)
+      }
+
+      offset += capacity * 8
+    }
+
+    this._heap = Buffer.from(buffer, offset, heapSize)
+  }
+
+  /**
+   * number of tables published so far, it's cheap to check for updates
+   * @returns {Number}
+   */
+  get generation () {
+    return Atomics.load(this._header, GENERATION)
+  }
+
+  /**
+   * call `fn(view)` with zero-copy views of a consistent table without locks,
+   * `fn` is called again when the table was updated meanwhile, so it
+   * should only read the view. The view has `generation`, `length`,
+   * `timestamp`, `truncated`, `fields`, columns of requested numeric fields
+   * and `string(field, index)`. It throws when no consistent table is read
+   * for a second, e.g. the writer died while publishing
+   * @param {Function} fn
+   * @returns {*} the result of `fn`
+   */
+  read (fn) {
+    let deadline = 0
+
+    for (let attempt = 0; ; ++attempt) {
+      if (attempt >= SPIN_ATTEMPTS) {
+        if (deadline === 0) {
+          deadline = Date.now() + READ_TIMEOUT
+        } else if (Date.now() > deadline) {
+          throw new Error(`table isn't consistent for ${READ_TIMEOUT} ms`)
+        }
+
+        Atomics.wait(sleeper, 0, 0, 1)
+      }
+
+      const seq = Atomics.load(this._header, SEQUENCE)
+
+      // the table is being written
+      if (seq & 1) {
+        continue
+      }
+
+      let result
+      let error = null
+
+      try {
+        result = fn(this._view())
+      } catch (err) {
+        error = err
+      }
+
+      // a torn read may throw as well, so the error is checked after
+      if (Atomics.load(this._header, SEQUENCE) !== seq) {
+        continue
+      }
+
+      if (error !== null) {
+        throw error
+      }
+
+      return result
+    }
+  }
+
+  /**
+   * copy the table to an array of objects with requested fields,
+   * 64-bit fields are numbers
+   * @returns {Array}
+   */
+  snapshot () {
+    return this.read(view => {
+      const fields = objectFields.filter(field => view.fields.indexOf(field) !== -1)
+      const list = new Array(view.length)
+
+      for (let i = 0; i < view.length; ++i) {
+        const proc = {}
+
+        for (const field of fields) {
+          if (stringColumns.indexOf(field) !== -1) {
+            proc[field] = view.string(field, i)
+          } else if (field === 'starttime') {
+            proc[field] = new Date(view.starttime[i])
+          } else {
+            proc[field] = view[field][i]
+          }
+        }
+
+        list[i] = proc
+      }
+
+      return list
+    })
+  }
+
+  _view () {
+    const header = this._header
+    const length = header[LENGTH]
+    const mask = header[FIELDS]
+    const flags = header[FLAGS]
+    const strings = this._strings
+    const heap = this._heap
+
+    const view = {
+      generation: header[GENERATION],
+      length,
+      timestamp: this._timestamp[TIMESTAMP],
+      truncated: (flags & (TRUNCATED_ROWS | TRUNCATED_STRINGS)) !== 0,
+      fields: maskFields.filter((field, bit) => (mask & (1 << bit)) !== 0),
+      string (field, index) {
+        const start = strings[field].offsets[index]
+        return heap.toString('utf8', start, start + strings[field].lengths[index])
+      }
+    }
+
+    for (const field of view.fields) {
+      if (this._columns[field]) {
+        view[field] = this._columns[field].subarray(0, length)
+      }
+    }
+
+    return view
+  }
+}
+
+module.exports = {
+  SharedTable
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "arena.h"  // NOLINT(build/include)
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/**
+ * size of the first chunk when nothing is reserved and the limit
+ * of the geometric growth, larger strings get chunks of their own
+ */
+static const size_t MIN_CHUNK = 1024;
+static const size_t MAX_CHUNK = 1024 * 1024;
+
+static const size_t MIN_SLOTS = 16;
+
+/**
+ * FNV-1a
+ */
+static uint32_t hash(const char *data, size_t size) {
+  uint32_t h = 2166136261u;
+
+  for (size_t i = 0; i < size; ++i) {
+    h ^= static_cast<uint8_t>(data[i]);
+    h *= 16777619u;
+  }
+
+  return h;
+}
+
+namespace pl {
+
+bool string_ref::operator==(const string_ref &other) const {
+  return size == other.size && !memcmp(data, other.data, size);
+}
+
+bool string_ref::operator==(const std::string &other) const {
+  return size == other.size() && !memcmp(data, other.data(), size);
+}
+
+void string_arena::reserve(size_t bytes) {
+  if (bytes <= left) {
+    return;
+  }
+
+  chunks.emplace_back(new char[bytes]);
+  cursor = chunks.back().get();
+  left = bytes;
+  last_chunk = bytes;
+}
+
+char *string_arena::allocate(size_t size) {
+  if (size > left) {
+    size_t next = std::min(std::max(last_chunk * 2, MIN_CHUNK), MAX_CHUNK);
+    reserve(std::max(next, size));
+  }
+
+  char *data = cursor;
+  cursor += size;
+  left -= size;
+
+  return data;
+}
+
+string_ref string_arena::store(const char *data, size_t size) {
+  if (size == 0) {
+    return string_ref();
+  }
+
+  char *copy = allocate(size + 1);
+
+  memcpy(copy, data, size);
+  copy[size] = '\0';
+
+  return string_ref(copy, static_cast<uint32_t>(size));
+}
+
+string_ref string_interner::intern(const char *data, size_t size) {
+  if (size == 0) {
+    return string_ref();
+  }
+
+  // keep the load factor below 1/2
+  if ((count + 1) * 2 > slots.size()) {
+    grow();
+  }
+
+  size_t mask = slots.size() - 1;
+  size_t i = hash(data, size) & mask;
+  string_ref value(data, static_cast<uint32_t>(size));
+
+  while (slots[i].data != NULL) {
+    if (slots[i] == value) {
+      return slots[i];
+    }
+
+    i = (i + 1) & mask;
+  }
+
+  slots[i] = arena->store(data, size);
+  ++count;
+
+  return slots[i];
+}
+
+void string_interner::grow() {
+  std::vector<string_ref> old(std::max(slots.size() * 2, MIN_SLOTS),
+    string_ref(NULL, 0));
+  old.swap(slots);
+
+  size_t mask = slots.size() - 1;
+
+  for (const string_ref &value : old) {
+    if (value.data == NULL) {
+      continue;
+    }
+
+    size_t i = hash(value.data, value.size) & mask;
+
+    while (slots[i].data != NULL) {
+      i = (i + 1) & mask;
+    }
+
+    slots[i] = value;
+  }
+}
+
+}  // namespace pl
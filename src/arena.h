@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_ARENA_H_
+#define SRC_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pl {
+
+/**
+ * null-terminated string kept by `string_arena`,
+ * it's valid while the arena is alive
+ */
+struct string_ref {
+  const char *data;
+  uint32_t size;
+
+  string_ref() : data(""), size(0) {}
+  string_ref(const char *data, uint32_t size) : data(data), size(size) {}
+
+  bool empty() const {
+    return size == 0;
+  }
+
+  const char *c_str() const {
+    return data;
+  }
+
+  std::string str() const {
+    return std::string(data, size);
+  }
+
+  bool operator==(const string_ref &other) const;
+  bool operator==(const std::string &other) const;
+
+  bool operator!=(const string_ref &other) const {
+    return !(*this == other);
+  }
+};
+
+/**
+ * bump allocator of strings of one snapshot, strings are never moved,
+ * so refs stay valid while it grows. Chunks grow geometrically,
+ * so the number of allocations doesn't depend on the number of processes.
+ * It isn't thread-safe, every reader thread fills its own arena
+ */
+class string_arena {
+ public:
+  string_arena() {}
+
+  string_arena(const string_arena &) = delete;
+  string_arena &operator=(const string_arena &) = delete;
+
+  /**
+   * make sure the next `bytes` are stored without allocation
+   */
+  void reserve(size_t bytes);
+
+  /**
+   * copy the string to the arena
+   */
+  string_ref store(const char *data, size_t size);
+
+  string_ref store(const std::string &value) {
+    return store(value.data(), value.size());
+  }
+
+ private:
+  char *allocate(size_t size);
+
+  std::vector<std::unique_ptr<char[]>> chunks;
+  char *cursor = NULL;
+  size_t left = 0;
+  size_t last_chunk = 0;
+};
+
+/**
+ * index of strings stored in the arena, repeated values
+ * like owners and paths are stored once. It's used only while
+ * the arena is filled, so the index isn't kept with the strings
+ */
+class string_interner {
+ public:
+  explicit string_interner(string_arena *arena) : arena(arena) {}
+
+  string_interner(const string_interner &) = delete;
+  string_interner &operator=(const string_interner &) = delete;
+
+  /**
+   * return the equal string stored before or store it
+   */
+  string_ref intern(const char *data, size_t size);
+
+  string_ref intern(const std::string &value) {
+    return intern(value.data(), value.size());
+  }
+
+ private:
+  void grow();
+
+  string_arena *arena;
+
+  // open addressing table, free slots have null data
+  std::vector<string_ref> slots;
+  size_t count = 0;
+};
+
+}  // namespace pl
+
+#endif  // SRC_ARENA_H_
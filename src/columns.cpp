@@ -0,0 +1,241 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "columns.h"  // NOLINT(build/include)
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+#include <string>
+
+namespace pl {
+
+column::column(column &&other)  // NOLINT(build/c++11)
+: data(other.data), size(other.size) {
+  other.data = NULL;
+  other.size = 0;
+}
+
+column &column::operator=(column &&other) {  // NOLINT(build/c++11)
+  if (this != &other) {
+    free(data);
+
+    data = other.data;
+    size = other.size;
+    other.data = NULL;
+    other.size = 0;
+  }
+
+  return *this;
+}
+
+column::~column() {
+  free(data);
+}
+
+void column::allocate(size_t bytes) {
+  free(data);
+
+  // empty buffers still need a valid pointer
+  data = static_cast<char *>(malloc(bytes ? bytes : 1));
+  size = bytes;
+
+  if (data == NULL) {
+    throw std::bad_alloc();
+  }
+}
+
+char *column::release() {
+  char *released = data;
+
+  data = NULL;
+  size = 0;
+
+  return released;
+}
+
+template<typename T, typename Getter>
+static void fill(const list_t &proclist, column *col, Getter get) {
+  col->allocate(proclist.size() * sizeof(T));
+  T *values = col->as<T>();
+
+  for (size_t i = 0; i < proclist.size(); ++i) {
+    values[i] = static_cast<T>(get(proclist[i]));
+  }
+}
+
+template<typename Getter>
+static void fill_wide(const list_t &proclist, column *col, bool wide,
+                      Getter get) {
+  if (wide) {
+    fill<uint64_t>(proclist, col, get);
+  } else {
+    fill<double>(proclist, col, get);
+  }
+}
+
+template<typename Getter>
+static void fill_strings(const list_t &proclist, string_column *col,
+                         Getter get) {
+  size_t total = 0;
+
+  for (auto &proc : proclist) {
+    total += get(proc).size;
+  }
+
+  col->offsets.allocate((proclist.size() + 1) * sizeof(uint32_t));
+  col->data.allocate(total);
+
+  uint32_t *offsets = col->offsets.as<uint32_t>();
+  uint32_t offset = 0;
+
+  for (size_t i = 0; i < proclist.size(); ++i) {
+    string_ref value = get(proclist[i]);
+
+    offsets[i] = offset;
+    memcpy(col->data.data + offset, value.data, value.size);
+    offset += value.size;
+  }
+
+  offsets[proclist.size()] = offset;
+}
+
+columns to_columns(const list_t &proclist,
+                   const struct process_fields &fields,
+                   bool wide) {
+  columns result;
+  result.length = proclist.size();
+
+  if (fields.pid) {
+    fill<uint32_t>(proclist, &result.pid,
+      [](const process &proc) { return proc.pid; });
+  }
+
+  if (fields.ppid) {
+    fill<uint32_t>(proclist, &result.ppid,
+      [](const process &proc) { return proc.ppid; });
+  }
+
+  if (fields.uid) {
+    fill<uint32_t>(proclist, &result.uid,
+      [](const process &proc) { return proc.uid; });
+  }
+
+  if (fields.threads) {
+    fill<uint32_t>(proclist, &result.threads,
+      [](const process &proc) { return proc.threads; });
+  }
+
+  if (fields.priority) {
+    fill<int32_t>(proclist, &result.priority,
+      [](const process &proc) { return proc.priority; });
+  }
+
+  if (fields.starttime) {
+    fill<double>(proclist, &result.starttime,
+      [](const process &proc) { return proc.starttime; });
+  }
+
+  if (fields.cpu) {
+    fill<double>(proclist, &result.cpu,
+      [](const process &proc) { return proc.cpu; });
+  }
+
+  if (fields.vmem) {
+    fill_wide(proclist, &result.vmem, wide,
+      [](const process &proc) { return proc.vmem; });
+  }
+
+  if (fields.pmem) {
+    fill_wide(proclist, &result.pmem, wide,
+      [](const process &proc) { return proc.pmem; });
+  }
+
+  if (fields.utime) {
+    fill_wide(proclist, &result.utime, wide,
+      [](const process &proc) { return proc.utime; });
+  }
+
+  if (fields.stime) {
+    fill_wide(proclist, &result.stime, wide,
+      [](const process &proc) { return proc.stime; });
+  }
+
+  if (fields.pss) {
+    fill_wide(proclist, &result.pss, wide,
+      [](const process &proc) { return proc.pss; });
+  }
+
+  if (fields.uss) {
+    fill_wide(proclist, &result.uss, wide,
+      [](const process &proc) { return proc.uss; });
+  }
+
+  if (fields.swap) {
+    fill_wide(proclist, &result.swap, wide,
+      [](const process &proc) { return proc.swap; });
+  }
+
+  if (fields.shared) {
+    fill_wide(proclist, &result.shared, wide,
+      [](const process &proc) { return proc.shared; });
+  }
+
+  if (fields.read_bytes) {
+    fill_wide(proclist, &result.read_bytes, wide,
+      [](const process &proc) { return proc.read_bytes; });
+  }
+
+  if (fields.write_bytes) {
+    fill_wide(proclist, &result.write_bytes, wide,
+      [](const process &proc) { return proc.write_bytes; });
+  }
+
+  if (fields.rchar) {
+    fill_wide(proclist, &result.rchar, wide,
+      [](const process &proc) { return proc.rchar; });
+  }
+
+  if (fields.wchar) {
+    fill_wide(proclist, &result.wchar, wide,
+      [](const process &proc) { return proc.wchar; });
+  }
+
+  if (fields.syscr) {
+    fill_wide(proclist, &result.syscr, wide,
+      [](const process &proc) { return proc.syscr; });
+  }
+
+  if (fields.syscw) {
+    fill_wide(proclist, &result.syscw, wide,
+      [](const process &proc) { return proc.syscw; });
+  }
+
+  if (fields.name) {
+    fill_strings(proclist, &result.name,
+      [](const process &proc) { return proc.name; });
+  }
+
+  if (fields.path) {
+    fill_strings(proclist, &result.path,
+      [](const process &proc) { return proc.path; });
+  }
+
+  if (fields.cmdline) {
+    fill_strings(proclist, &result.cmdline,
+      [](const process &proc) { return proc.cmdline; });
+  }
+
+  if (fields.owner) {
+    fill_strings(proclist, &result.owner,
+      [](const process &proc) { return proc.owner; });
+  }
+
+  return result;
+}
+
+}  // namespace pl
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_COLUMNS_H_
+#define SRC_COLUMNS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tasklist.h"  // NOLINT(build/include)
+
+namespace pl {
+
+/**
+ * `malloc`ed memory, it's filled on the worker thread
+ * and handed over to js buffer without copy
+ */
+class column {
+ public:
+  column() : data(NULL), size(0) {}
+  column(column &&other);  // NOLINT(build/c++11)
+  column &operator=(column &&other);  // NOLINT(build/c++11)
+  ~column();
+
+  column(const column &) = delete;
+  column &operator=(const column &) = delete;
+
+  void allocate(size_t size);
+
+  /**
+   * give up the ownership of memory, it should be released with `free`
+   */
+  char *release();
+
+  template<typename T>
+  T *as() const {
+    return reinterpret_cast<T *>(data);
+  }
+
+  char *data;
+  size_t size;
+};
+
+/**
+ * strings as one utf-8 buffer, string `i` is `[offsets[i], offsets[i + 1])`
+ */
+struct string_column {
+  column offsets;
+  column data;
+};
+
+/**
+ * process list as columns, only requested fields are allocated
+ */
+struct columns {
+  size_t length = 0;
+
+  column pid;
+  column ppid;
+  column uid;
+  column threads;
+  column priority;
+  column starttime;
+  column vmem;
+  column pmem;
+  column cpu;
+  column utime;
+  column stime;
+  column pss;
+  column uss;
+  column swap;
+  column shared;
+  column read_bytes;
+  column write_bytes;
+  column rchar;
+  column wchar;
+  column syscr;
+  column syscw;
+
+  string_column name;
+  string_column path;
+  string_column cmdline;
+  string_column owner;
+};
+
+/**
+ * convert process list to columns:
+ * `uint32_t` pid, ppid, uid, threads; `int32_t` priority;
+ * `double` starttime (ms since epoch) and cpu;
+ * `uint64_t` vmem, pmem, utime, stime, memory and io counters,
+ * or `double` when `wide` is false
+ */
+columns to_columns(const list_t &proclist,
+                   const struct process_fields &fields,
+                   bool wide);
+
+}  // namespace pl
+
+#endif  // SRC_COLUMNS_H_
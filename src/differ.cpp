@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "differ.h"  // NOLINT(build/include)
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**
+ * check if numeric field has changed more than threshold
+ */
+template<typename T>
+static inline bool exceeds(T prev, T next, double threshold) {
+  double delta = std::fabs(static_cast<double>(next) - prev);
+  return threshold > 0 ? delta >= threshold : delta > 0;
+}
+
+namespace pl {
+
+differ::differ(const struct diff_thresholds &thresholds)
+: thresholds(thresholds) {
+}
+
+bool differ::changed(const process &prev, const process &next,
+                     const struct process_fields &fields) const {
+  return (fields.ppid && prev.ppid != next.ppid) ||
+    (fields.path && prev.path != next.path) ||
+    (fields.name && prev.name != next.name) ||
+    (fields.owner && prev.owner != next.owner) ||
+    (fields.uid && prev.uid != next.uid) ||
+    (fields.cmdline && prev.cmdline != next.cmdline) ||
+    (fields.threads &&
+      exceeds(prev.threads, next.threads, thresholds.threads)) ||
+    (fields.priority &&
+      exceeds(prev.priority, next.priority, thresholds.priority)) ||
+    (fields.vmem && exceeds(prev.vmem, next.vmem, thresholds.vmem)) ||
+    (fields.pmem && exceeds(prev.pmem, next.pmem, thresholds.pmem)) ||
+    (fields.cpu && exceeds(prev.cpu, next.cpu, thresholds.cpu)) ||
+    (fields.utime && exceeds(prev.utime, next.utime, thresholds.utime)) ||
+    (fields.stime && exceeds(prev.stime, next.stime, thresholds.stime)) ||
+    (fields.pss && exceeds(prev.pss, next.pss, thresholds.pss)) ||
+    (fields.uss && exceeds(prev.uss, next.uss, thresholds.uss)) ||
+    (fields.swap && exceeds(prev.swap, next.swap, thresholds.swap)) ||
+    (fields.shared && exceeds(prev.shared, next.shared, thresholds.shared)) ||
+    (fields.read_bytes &&
+      exceeds(prev.read_bytes, next.read_bytes, thresholds.read_bytes)) ||
+    (fields.write_bytes &&
+      exceeds(prev.write_bytes, next.write_bytes, thresholds.write_bytes)) ||
+    (fields.rchar && exceeds(prev.rchar, next.rchar, thresholds.rchar)) ||
+    (fields.wchar && exceeds(prev.wchar, next.wchar, thresholds.wchar)) ||
+    (fields.syscr && exceeds(prev.syscr, next.syscr, thresholds.syscr)) ||
+    (fields.syscw && exceeds(prev.syscw, next.syscw, thresholds.syscw));
+}
+
+diff_t differ::diff(const struct process_fields &requested_fields,
+                    const struct list_options &options) {
+  std::lock_guard<std::mutex> guard(lock);
+
+  // fields required to identify processes
+  struct process_fields fields = requested_fields;
+  fields.pid = fields.starttime = true;
+
+  list_t proclist = list(fields, options);
+
+  diff_t result;
+  std::unordered_map<process_key, process, process_key_hash> current;
+  current.reserve(proclist.size());
+
+  for (auto &proc : proclist) {
+    process_key key(proc);
+    auto prev = previous.find(key);
+
+    if (prev != previous.end() && !changed(prev->second, proc, fields)) {
+      // keep the last reported state, so slow drift is reported
+      // as soon as it exceeds the threshold
+      current.emplace(key, std::move(prev->second));
+    } else {
+      auto &target = (prev == previous.end()) ? result.added : result.changed;
+
+      // the process may be kept for many diffs, the snapshot arena is not
+      own_strings(&proc);
+      target.push_back(proc);
+      current.emplace(key, std::move(proc));
+    }
+
+    if (prev != previous.end()) {
+      previous.erase(prev);
+    }
+  }
+
+  // everything left wasn't found in the current list
+  result.removed.reserve(previous.size());
+
+  for (auto &entry : previous) {
+    result.removed.push_back(std::move(entry.second));
+  }
+
+  std::sort(result.removed.begin(), result.removed.end(),
+    [](const process &a, const process &b) { return a.pid < b.pid; });
+
+  previous.swap(current);
+  return result;
+}
+
+}  // namespace pl
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_DIFFER_H_
+#define SRC_DIFFER_H_
+
+#include <stdint.h>
+#include <mutex>  // NOLINT(build/c++11)
+#include <unordered_map>
+
+#include "tasklist.h"  // NOLINT(build/include)
+
+namespace pl {
+
+/**
+ * minimal change of numeric fields to report the process as changed,
+ * 0 means any change
+ */
+struct diff_thresholds {
+  double threads = 0;
+  double priority = 0;
+  double vmem = 0;
+  double pmem = 0;
+  double cpu = 0;
+  double utime = 0;
+  double stime = 0;
+  double pss = 0;
+  double uss = 0;
+  double swap = 0;
+  double shared = 0;
+  double read_bytes = 0;
+  double write_bytes = 0;
+  double rchar = 0;
+  double wchar = 0;
+  double syscr = 0;
+  double syscw = 0;
+};
+
+struct diff_t {
+  list_t added;
+  list_t removed;
+  list_t changed;
+};
+
+/**
+ * keeps the previous process list and returns only the difference,
+ * processes are identified by (pid, starttime), so reused pids
+ * are reported as removed and added
+ */
+class differ {
+ public:
+  explicit differ(const struct diff_thresholds &thresholds);
+
+  diff_t diff(const struct process_fields &, const struct list_options &);
+
+ private:
+  bool changed(const process &prev, const process &next,
+               const struct process_fields &fields) const;
+
+  std::mutex lock;
+  diff_thresholds thresholds;
+
+  // last reported state of every process
+  std::unordered_map<process_key, process, process_key_hash> previous;
+};
+
+}  // namespace pl
+
+#endif  // SRC_DIFFER_H_
@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "differ_wrap.h"  // NOLINT(build/include)
+
+#include <nan.h>
+
+#include <cmath>
+
+#include "snapshot.h"  // NOLINT(build/include)
+
+using v8::FunctionTemplate;
+using v8::Function;
+using v8::Object;
+using v8::Local;
+using v8::Value;
+using pl::process_fields;
+using pl::list_options;
+
+#define STR(s) Nan::New<v8::String>(s).ToLocalChecked()
+
+/**
+ * read non-negative number, any other value means 0
+ */
+static double threshold(Local<Object> obj, const char *prop) {
+  double value = Nan::To<double>(Nan::Get(obj, STR(prop)).ToLocalChecked())
+    .FromMaybe(0);
+
+  return (std::isnan(value) || value < 0) ? 0 : value;
+}
+
+class DiffWorker : public SnapshotWorker {
+ public:
+  DiffWorker(Nan::Callback *callback,
+             const struct process_fields &fields,
+             const struct list_options &options,
+             const struct output_options &output,
+             pl::differ *differ)
+  : SnapshotWorker(callback, fields, options, output), differ(differ) {
+    // processes are identified by (pid, starttime),
+    // so removed ones are useless without them
+    psfields.pid = psfields.starttime = true;
+  }
+
+  void Execute() {
+    try {
+      {
+        pl::probe measure(psoptions.stats, pl::PHASE_SCAN);
+        diff = differ->diff(psfields, psoptions);
+      }
+
+      if (psoptions.stats) {
+        pl::record(stats);
+      }
+    } catch(const std::exception &e) {
+      SetErrorMessage(e.what());
+    }
+  }
+
+  void HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    Local<Object> result = Nan::New<Object>();
+
+    {
+      pl::probe measure(psoptions.stats, pl::PHASE_CONVERT);
+
+      Nan::Set(result, STR("added"),
+        to_array(diff.added, psfields, psoutput));
+      Nan::Set(result, STR("removed"),
+        to_array(diff.removed, psfields, psoutput));
+      Nan::Set(result, STR("changed"),
+        to_array(diff.changed, psfields, psoutput));
+    }
+
+    if (psoptions.stats) {
+      attach_stats(result, stats);
+    }
+
+    Local<Value> argv[] = {
+      Nan::Null(),
+      result
+    };
+
+    callback->Call(2, argv, async_resource);
+  }
+
+ private:
+  pl::differ *differ;
+  pl::diff_t diff;
+};
+
+NAN_MODULE_INIT(Differ::Init) {
+  Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+  tpl->SetClassName(Nan::New("Differ").ToLocalChecked());
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::SetPrototypeMethod(tpl, "diff", Diff);
+
+  Nan::Set(target, Nan::New("Differ").ToLocalChecked(),
+    Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+NAN_METHOD(Differ::New) {
+  if (!info.IsConstructCall()) {
+    return Nan::ThrowTypeError("Class constructor Differ cannot be invoked "
+      "without 'new'");
+  }
+
+  auto arg0 = info[0].As<Object>();
+
+  struct pl::diff_thresholds thresholds;
+  thresholds.threads = threshold(arg0, "threads");
+  thresholds.priority = threshold(arg0, "priority");
+  thresholds.vmem = threshold(arg0, "vmem");
+  thresholds.pmem = threshold(arg0, "pmem");
+  thresholds.cpu = threshold(arg0, "cpu");
+  thresholds.utime = threshold(arg0, "utime");
+  thresholds.stime = threshold(arg0, "stime");
+  thresholds.pss = threshold(arg0, "pss");
+  thresholds.uss = threshold(arg0, "uss");
+  thresholds.swap = threshold(arg0, "swap");
+  thresholds.shared = threshold(arg0, "shared");
+  thresholds.read_bytes = threshold(arg0, "readBytes");
+  thresholds.write_bytes = threshold(arg0, "writeBytes");
+  thresholds.rchar = threshold(arg0, "rchar");
+  thresholds.wchar = threshold(arg0, "wchar");
+  thresholds.syscr = threshold(arg0, "syscr");
+  thresholds.syscw = threshold(arg0, "syscw");
+
+  Differ *obj = new Differ(thresholds);
+  obj->Wrap(info.This());
+
+  info.GetReturnValue().Set(info.This());
+}
+
+NAN_METHOD(Differ::Diff) {
+  Differ *obj = Nan::ObjectWrap::Unwrap<Differ>(info.Holder());
+
+  auto fields = process_fields_from(info[0].As<Object>());
+  auto options = list_options_from(info[1].As<Object>());
+  auto output = output_options_from(info[1].As<Object>());
+  auto *callback = new Nan::Callback(info[2].As<Function>());
+
+  // only array of objects is supported for lists of the difference
+  output.columnar = false;
+
+  auto *worker = new DiffWorker(callback, fields, options, output,
+    &obj->differ);
+
+  // keep the differ alive until the worker is done
+  worker->SaveToPersistent("differ", info.Holder());
+
+  queue_worker(worker, info[1].As<Object>());
+}
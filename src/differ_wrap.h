@@ -0,0 +1,32 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_DIFFER_WRAP_H_
+#define SRC_DIFFER_WRAP_H_
+
+#include <nan.h>
+
+#include "differ.h"  // NOLINT(build/include)
+
+/**
+ * js binding of `pl::differ`
+ */
+class Differ : public Nan::ObjectWrap {
+ public:
+  static NAN_MODULE_INIT(Init);
+
+ private:
+  explicit Differ(const struct pl::diff_thresholds &thresholds)
+  : differ(thresholds) {}
+  ~Differ() {}
+
+  static NAN_METHOD(New);
+  static NAN_METHOD(Diff);
+
+  pl::differ differ;
+};
+
+#endif  // SRC_DIFFER_WRAP_H_
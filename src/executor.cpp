@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "executor.h"  // NOLINT(build/include)
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
+/**
+ * state shared with the thread of one event loop. The thread owns
+ * a reference, so it outlives the loop when it's busy at teardown
+ */
+struct executor {
+  std::mutex lock;
+  std::condition_variable wakeup;
+  std::deque<Nan::AsyncWorker *> queued;
+  std::deque<Nan::AsyncWorker *> completed;
+  // set on teardown of the loop, the handle is closed then
+  bool stopped = false;
+
+  // the handle and the counter are touched only on the event loop
+  uv_async_t *async;
+  size_t pending = 0;
+};
+
+/**
+ * one executor per event loop, workers are completed on the loop
+ * of their caller
+ */
+static std::mutex instances_lock;
+static std::map<uv_loop_t *, std::shared_ptr<executor>> instances;
+
+/**
+ * body of the dedicated thread, it lives until its loop is torn down
+ */
+static void run(std::shared_ptr<executor> self) {
+  for (;;) {
+    Nan::AsyncWorker *worker;
+
+    {
+      std::unique_lock<std::mutex> guard(self->lock);
+      self->wakeup.wait(guard, [&self]() {
+        return self->stopped || !self->queued.empty();
+      });
+
+      if (self->stopped) {
+        return;
+      }
+
+      worker = self->queued.front();
+      self->queued.pop_front();
+    }
+
+    worker->Execute();
+
+    std::lock_guard<std::mutex> guard(self->lock);
+
+    // the loop is gone, nothing can complete the worker
+    if (self->stopped) {
+      return;
+    }
+
+    self->completed.push_back(worker);
+    uv_async_send(self->async);
+  }
+}
+
+/**
+ * call js callbacks of executed workers, it's called on the event loop
+ */
+static void complete(uv_async_t *handle) {
+  executor *self = static_cast<executor *>(handle->data);
+  std::deque<Nan::AsyncWorker *> done;
+
+  {
+    std::lock_guard<std::mutex> guard(self->lock);
+    done.swap(self->completed);
+  }
+
+  for (auto *worker : done) {
+    worker->WorkComplete();
+    worker->Destroy();
+    --self->pending;
+  }
+
+  // an idle thread doesn't keep the event loop alive
+  if (self->pending == 0) {
+    uv_unref(reinterpret_cast<uv_handle_t *>(handle));
+  }
+}
+
+static void close_async(uv_handle_t *handle) {
+  delete reinterpret_cast<uv_async_t *>(handle);
+}
+
+#if NODE_VERSION_AT_LEAST(10, 2, 0)
+/**
+ * teardown of the environment: stop the thread and drop workers
+ * which won't be completed, the thread isn't joined to not block
+ * the exit behind a running worker
+ */
+static void stop(void *data) {
+  uv_loop_t *loop = static_cast<uv_loop_t *>(data);
+  std::shared_ptr<executor> self;
+
+  {
+    std::lock_guard<std::mutex> guard(instances_lock);
+    auto found = instances.find(loop);
+
+    if (found == instances.end()) {
+      return;
+    }
+
+    self = found->second;
+    instances.erase(found);
+  }
+
+  std::deque<Nan::AsyncWorker *> dropped;
+
+  {
+    std::lock_guard<std::mutex> guard(self->lock);
+    self->stopped = true;
+    dropped.swap(self->queued);
+    dropped.insert(dropped.end(), self->completed.begin(),
+      self->completed.end());
+    self->completed.clear();
+  }
+
+  self->wakeup.notify_one();
+
+  for (auto *worker : dropped) {
+    worker->Destroy();
+  }
+
+  uv_close(reinterpret_cast<uv_handle_t *>(self->async), close_async);
+}
+#endif
+
+/**
+ * executor of the current event loop, it's created on the first call
+ */
+static std::shared_ptr<executor> current() {
+  uv_loop_t *loop = Nan::GetCurrentEventLoop();
+  std::lock_guard<std::mutex> guard(instances_lock);
+  auto &instance = instances[loop];
+
+  if (!instance) {
+    instance = std::make_shared<executor>();
+    instance->async = new uv_async_t;
+    uv_async_init(loop, instance->async, complete);
+    instance->async->data = instance.get();
+    uv_unref(reinterpret_cast<uv_handle_t *>(instance->async));
+
+#if NODE_VERSION_AT_LEAST(10, 2, 0)
+    node::AddEnvironmentCleanupHook(v8::Isolate::GetCurrent(), stop, loop);
+#endif
+
+    std::thread(run, instance).detach();
+  }
+
+  return instance;
+}
+
+void DedicatedQueueWorker(Nan::AsyncWorker *worker) {
+  std::shared_ptr<executor> self = current();
+
+  if (self->pending++ == 0) {
+    uv_ref(reinterpret_cast<uv_handle_t *>(self->async));
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(self->lock);
+    self->queued.push_back(worker);
+  }
+
+  self->wakeup.notify_one();
+}
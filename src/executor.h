@@ -0,0 +1,21 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_EXECUTOR_H_
+#define SRC_EXECUTOR_H_
+
+#include <nan.h>
+
+/**
+ * run the worker on a native thread owned by the addon instead of
+ * the libuv thread pool, so it doesn't wait behind fs, dns and crypto
+ * jobs. Every event loop has its own thread, workers are executed one
+ * by one, then completed on the loop of the caller like with
+ * `Nan::AsyncQueueWorker`
+ */
+void DedicatedQueueWorker(Nan::AsyncWorker *worker);
+
+#endif  // SRC_EXECUTOR_H_
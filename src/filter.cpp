@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "filter.h"  // NOLINT(build/include)
+
+#include <algorithm>
+
+namespace pl {
+
+bool glob(const char *pattern, const char *str) {
+  const char *star = NULL;
+  const char *backtrack = NULL;
+
+  while (*str) {
+    if (*pattern == '*') {
+      star = pattern++;
+      backtrack = str;
+    } else if (*pattern == '?' || *pattern == *str) {
+      ++pattern;
+      ++str;
+    } else if (star) {
+      // let the last `*` consume one more char
+      pattern = star + 1;
+      str = ++backtrack;
+    } else {
+      return false;
+    }
+  }
+
+  while (*pattern == '*') {
+    ++pattern;
+  }
+
+  return *pattern == '\0';
+}
+
+bool match_pid(const struct process_filter &filter, uint32_t pid) {
+  return filter.pids.empty() ||
+    std::binary_search(filter.pids.begin(), filter.pids.end(), pid);
+}
+
+bool match(const struct process_filter &filter, const process &proc) {
+  return match_pid(filter, proc.pid) &&
+    (!filter.has_ppid || proc.ppid == filter.ppid) &&
+    (!filter.has_uid || proc.uid == filter.uid) &&
+    (filter.owner.empty() || proc.owner == filter.owner) &&
+    (filter.name.empty() || glob(filter.name.c_str(), proc.name.c_str()));
+}
+
+}  // namespace pl
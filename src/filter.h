@@ -0,0 +1,34 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_FILTER_H_
+#define SRC_FILTER_H_
+
+#include <stdint.h>
+
+#include "tasklist.h"  // NOLINT(build/include)
+
+namespace pl {
+
+/**
+ * match string against glob pattern with `*` and `?` wildcards
+ */
+bool glob(const char *pattern, const char *str);
+
+/**
+ * check if pid passes the filter
+ */
+bool match_pid(const struct process_filter &filter, uint32_t pid);
+
+/**
+ * check if the process passes the filter, for scanners
+ * which can't check fields one by one
+ */
+bool match(const struct process_filter &filter, const process &proc);
+
+}  // namespace pl
+
+#endif  // SRC_FILTER_H_
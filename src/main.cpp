@@ -6,9 +6,30 @@
 
 #include <nan.h>
 #include "snapshot.h"  // NOLINT(build/include)
+#include "sampler_wrap.h"  // NOLINT(build/include)
+#include "differ_wrap.h"  // NOLINT(build/include)
+#include "tree_wrap.h"  // NOLINT(build/include)
+#include "stream_wrap.h"  // NOLINT(build/include)
+
+#ifdef __linux__
+#include "unix/watcher_wrap.h"  // NOLINT(build/include)
+#endif
 
 NAN_MODULE_INIT(init) {
+  init_keys();
+
   Nan::Export(target, "snapshot", snapshot);
+  Nan::Export(target, "snapshotSync", snapshotSync);
+  Nan::Export(target, "getStats", getStats);
+  Nan::Export(target, "tree", tree);
+
+  Sampler::Init(target);
+  Differ::Init(target);
+  Stream::Init(target);
+
+#ifdef __linux__
+  Watcher::Init(target);
+#endif
 }
 
 NODE_MODULE(processlist, init);
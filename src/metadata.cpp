@@ -0,0 +1,147 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "metadata.h"  // NOLINT(build/include)
+
+#include <string>
+
+namespace pl {
+
+metadata_cache &metadata_cache::shared() {
+  // never destroyed, readers may still use it while the process exits
+  static metadata_cache *cache = new metadata_cache();
+  return *cache;
+}
+
+void metadata_cache::bind(const std::string &procfs) {
+  std::lock_guard<std::mutex> guard(root_lock);
+
+  if (procfs == root) {
+    return;
+  }
+
+  root = procfs;
+
+  for (shard &sh : shards) {
+    std::lock_guard<std::mutex> lock(sh.lock);
+
+    size -= sh.entries.size();
+    sh.entries.clear();
+  }
+}
+
+void metadata_cache::next_epoch() {
+  ++epoch;
+}
+
+bool metadata_cache::lookup(const process_key &key,
+                            const exec_signature &signature,
+                            string_interner *interned, string_arena *strings,
+                            process_metadata *found) {
+  shard &sh = shard_of(key);
+  std::lock_guard<std::mutex> guard(sh.lock);
+  auto it = sh.entries.find(key);
+
+  if (it == sh.entries.end()) {
+    ++misses;
+    return false;
+  }
+
+  entry &cached = it->second;
+
+  if (!(cached.signature == signature)) {
+    sh.entries.erase(it);
+    --size;
+    ++invalidations;
+    ++misses;
+    return false;
+  }
+
+  cached.epoch = epoch;
+  ++hits;
+
+  found->has_path = cached.has_path;
+  found->has_cmdline = cached.has_cmdline;
+  found->path = interned->intern(cached.path);
+  found->cmdline = strings->store(cached.cmdline);
+
+  return true;
+}
+
+void metadata_cache::store(const process_key &key,
+                           const exec_signature &signature,
+                           const process_metadata &data, size_t limit) {
+  shard &sh = shard_of(key);
+  size_t shard_limit = (limit + SHARDS - 1) / SHARDS;
+  uint64_t current = epoch;
+
+  std::lock_guard<std::mutex> guard(sh.lock);
+  auto it = sh.entries.find(key);
+
+  if (it == sh.entries.end()) {
+    // a scan of a full shard frees nothing until the next snapshot
+    if (sh.full_epoch == current && sh.entries.size() >= shard_limit) {
+      return;
+    }
+
+    // drop processes seen by neither the previous nor the current snapshot,
+    // the current scan may not have reached live ones of the previous yet
+    if (sh.entries.size() >= shard_limit) {
+      for (auto i = sh.entries.begin(); i != sh.entries.end();) {
+        if (i->second.epoch + 1 < current) {
+          i = sh.entries.erase(i);
+          --size;
+          ++evictions;
+        } else {
+          ++i;
+        }
+      }
+    }
+
+    if (sh.entries.size() >= shard_limit) {
+      sh.full_epoch = current;
+      return;
+    }
+
+    it = sh.entries.emplace(key, entry()).first;
+    it->second.has_path = it->second.has_cmdline = false;
+    ++size;
+  }
+
+  entry &cached = it->second;
+
+  // a partial entry is completed by the snapshot with more fields
+  if (!(cached.signature == signature)) {
+    cached.has_path = cached.has_cmdline = false;
+    cached.signature = signature;
+  }
+
+  if (data.has_path) {
+    cached.has_path = true;
+    cached.path = data.path.str();
+  }
+
+  if (data.has_cmdline) {
+    cached.has_cmdline = true;
+    cached.cmdline = data.cmdline.str();
+  }
+
+  cached.epoch = current;
+}
+
+metadata_counters metadata_cache::counters() const {
+  metadata_counters result = {
+    size,
+    hits,
+    misses,
+    invalidations,
+    evictions
+  };
+
+  return result;
+}
+
+}  // namespace pl
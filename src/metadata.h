@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_METADATA_H_
+#define SRC_METADATA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+
+#include "arena.h"  // NOLINT(build/include)
+#include "tasklist.h"  // NOLINT(build/include)
+
+namespace pl {
+
+/**
+ * cheap sign of `execve`: it changes `comm`
+ * and usually the inode of the `exe` link target
+ */
+struct exec_signature {
+  std::string comm;
+  uint64_t dev = 0;
+  uint64_t ino = 0;
+
+  bool operator==(const exec_signature &other) const {
+    return dev == other.dev && ino == other.ino && comm == other.comm;
+  }
+};
+
+/**
+ * path and cmdline of the process, missing ones aren't read yet
+ */
+struct process_metadata {
+  bool has_path = false;
+  bool has_cmdline = false;
+
+  string_ref path;
+  string_ref cmdline;
+};
+
+/**
+ * counters of the cache since the start
+ */
+struct metadata_counters {
+  uint64_t size;
+  uint64_t hits;
+  uint64_t misses;
+
+  // entries dropped because the process has called `execve`
+  uint64_t invalidations;
+
+  // entries dropped because the cache is full
+  uint64_t evictions;
+};
+
+/**
+ * path and cmdline of processes by (pid, starttime) kept between snapshots,
+ * they only change on `execve`. The cache is split into shards by pid,
+ * so parallel readers rarely wait for each other
+ */
+class metadata_cache {
+ public:
+  /**
+   * the cache shared by all snapshots
+   */
+  static metadata_cache &shared();
+
+  /**
+   * entries belong to one procfs root,
+   * the cache is cleared when another one is used
+   */
+  void bind(const std::string &root);
+
+  /**
+   * start the next snapshot, entries not used by the latest two
+   * are dropped when the cache is full
+   */
+  void next_epoch();
+
+  /**
+   * copy cached strings of the process to the arena,
+   * return false when nothing is cached or the process has called `execve`
+   */
+  bool lookup(const process_key &key, const exec_signature &signature,
+              string_interner *interned, string_arena *strings,
+              process_metadata *found);
+
+  /**
+   * cache strings of the process, up to `limit` processes are kept
+   */
+  void store(const process_key &key, const exec_signature &signature,
+             const process_metadata &data, size_t limit);
+
+  metadata_counters counters() const;
+
+ private:
+  struct entry {
+    exec_signature signature;
+    bool has_path;
+    bool has_cmdline;
+    std::string path;
+    std::string cmdline;
+    uint64_t epoch;
+  };
+
+  struct shard {
+    std::mutex lock;
+    std::unordered_map<process_key, entry, process_key_hash> entries;
+
+    // the epoch in which the shard is full of entries used by it,
+    // nothing can be evicted until the next one
+    uint64_t full_epoch = 0;
+  };
+
+  static const size_t SHARDS = 16;
+
+  shard &shard_of(const process_key &key) {
+    return shards[key.pid % SHARDS];
+  }
+
+  shard shards[SHARDS];
+
+  std::mutex root_lock;
+  std::string root;
+
+  std::atomic<uint64_t> epoch{0};
+  std::atomic<uint64_t> size{0};
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+  std::atomic<uint64_t> invalidations{0};
+  std::atomic<uint64_t> evictions{0};
+};
+
+}  // namespace pl
+
+#endif  // SRC_METADATA_H_
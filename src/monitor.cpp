@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "monitor.h"  // NOLINT(build/include)
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <exception>
+#include <set>
+#include <string>
+
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+using std::chrono::system_clock;
+
+/**
+ * running monitors, they are stopped at exit,
+ * so scans don't touch destroyed static data
+ */
+static std::mutex registry_lock;
+static std::set<pl::monitor *> registry;
+
+static void stop_all() {
+  std::set<pl::monitor *> running;
+
+  {
+    std::lock_guard<std::mutex> guard(registry_lock);
+    running.swap(registry);
+  }
+
+  for (auto *monitor : running) {
+    monitor->stop();
+  }
+}
+
+static void enroll(pl::monitor *monitor) {
+  static bool registered = (atexit(stop_all) == 0);
+  (void)registered;
+
+  std::lock_guard<std::mutex> guard(registry_lock);
+  registry.insert(monitor);
+}
+
+static void leave(pl::monitor *monitor) {
+  std::lock_guard<std::mutex> guard(registry_lock);
+  registry.erase(monitor);
+}
+
+namespace pl {
+
+monitor::monitor()
+: interval(0), stopped(true) {
+}
+
+monitor::~monitor() {
+  stop();
+}
+
+void monitor::start(const struct process_fields &requested_fields,
+                    const struct list_options &list_options,
+                    uint32_t scan_interval) {
+  stop();
+
+  fields = requested_fields;
+  options = list_options;
+  interval = scan_interval;
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopped = false;
+    current.reset();
+    last_error.clear();
+  }
+
+  enroll(this);
+  thread = std::thread(&monitor::run, this);
+}
+
+void monitor::stop() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopped = true;
+  }
+
+  wakeup.notify_all();
+
+  if (thread.joinable()) {
+    thread.join();
+  }
+
+  leave(this);
+}
+
+std::shared_ptr<const sample_t> monitor::latest() {
+  std::lock_guard<std::mutex> guard(lock);
+  return current;
+}
+
+std::string monitor::error() {
+  std::lock_guard<std::mutex> guard(lock);
+  return last_error;
+}
+
+void monitor::share(std::unique_ptr<shared_table> next) {
+  auto sample = latest();
+
+  std::lock_guard<std::mutex> guard(table_lock);
+  table.swap(next);
+
+  if (table && sample) {
+    table->publish(sample->list, fields, sample->timestamp);
+  }
+}
+
+void monitor::publish(const sample_t &sample) {
+  std::lock_guard<std::mutex> guard(table_lock);
+
+  if (table) {
+    table->publish(sample.list, fields, sample.timestamp);
+  }
+}
+
+void monitor::run() {
+  std::unique_lock<std::mutex> guard(lock);
+
+  while (!stopped) {
+    guard.unlock();
+
+    auto start = steady_clock::now();
+    auto next = std::make_shared<sample_t>();
+    std::string failure;
+
+    try {
+      next->list = source.sample(fields, options);
+    } catch(const std::exception &e) {
+      failure = e.what();
+    }
+
+    uint64_t duration = duration_cast<milliseconds>(
+      steady_clock::now() - start).count();
+
+    next->timestamp = duration_cast<milliseconds>(
+      system_clock::now().time_since_epoch()).count();
+    next->duration = duration;
+    next->period = std::max<uint64_t>(interval, duration * 2);
+
+    guard.lock();
+
+    if (failure.empty()) {
+      current = next;
+      guard.unlock();
+
+      publish(*next);
+      guard.lock();
+    }
+
+    last_error = failure;
+
+    wakeup.wait_for(guard, milliseconds(next->period - duration),
+      [this]() { return stopped; });
+  }
+}
+
+}  // namespace pl
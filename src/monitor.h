@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_MONITOR_H_
+#define SRC_MONITOR_H_
+
+#include <stdint.h>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "sampler.h"  // NOLINT(build/include)
+#include "shared_table.h"  // NOLINT(build/include)
+#include "tasklist.h"  // NOLINT(build/include)
+
+namespace pl {
+
+/**
+ * process list published by the background thread
+ */
+struct sample_t {
+  list_t list;
+
+  // ms since epoch when the scan has finished
+  uint64_t timestamp;
+
+  // how long the scan took and the period of scans, ms
+  uint64_t duration;
+  uint64_t period;
+};
+
+/**
+ * reads processes through its own sampler on its own thread at the interval,
+ * so `sampler::sample()` calls of the caller don't reset its baseline.
+ * The newest complete list is swapped in, so readers never wait for a scan
+ * and keep the list they got while the next one is built. The period grows
+ * when a scan takes more than a half of the interval
+ */
+class monitor {
+ public:
+  monitor();
+  ~monitor();
+
+  /**
+   * start scanning, a running monitor is restarted
+   */
+  void start(const struct process_fields &, const struct list_options &,
+             uint32_t interval);
+
+  void stop();
+
+  /**
+   * the newest complete sample, null before the first scan is done
+   */
+  std::shared_ptr<const sample_t> latest();
+
+  /**
+   * error of the last scan, empty if it succeeded
+   */
+  std::string error();
+
+  /**
+   * publish every sample to the table too, the current one is published
+   * at once. The previous table isn't touched after the call
+   */
+  void share(std::unique_ptr<shared_table> table);
+
+ private:
+  void run();
+  void publish(const sample_t &sample);
+
+  sampler source;
+  struct process_fields fields;
+  struct list_options options;
+  uint32_t interval;
+
+  std::thread thread;
+  std::mutex lock;
+  std::condition_variable wakeup;
+  bool stopped;
+
+  std::shared_ptr<const sample_t> current;
+  std::string last_error;
+
+  // guards the table while it's written
+  std::mutex table_lock;
+  std::unique_ptr<shared_table> table;
+};
+
+}  // namespace pl
+
+#endif  // SRC_MONITOR_H_
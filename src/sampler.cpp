@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "sampler.h"  // NOLINT(build/include)
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
+/**
+ * growth of a counter per millisecond since the previous sample,
+ * or since the start without the previous sample
+ */
+static double per_ms(uint64_t value, uint64_t starttime,
+                     const uint64_t *prev, uint64_t prev_timestamp,
+                     uint64_t timestamp) {
+  uint64_t used = value;
+  uint64_t since = starttime;
+
+  if (prev && value >= *prev) {
+    used = value - *prev;
+    since = prev_timestamp;
+  }
+
+  uint64_t elapsed = (timestamp > since) ? timestamp - since : 0;
+  return (elapsed == 0) ? 0 : static_cast<double>(used) / elapsed;
+}
+
+/**
+ * cpu usage in percent of one core
+ */
+static double usage(uint64_t cpu, uint64_t starttime,
+                    const uint64_t *prev, uint64_t prev_timestamp,
+                    uint64_t timestamp) {
+  return per_ms(cpu, starttime, prev, prev_timestamp, timestamp) * 100;
+}
+
+/**
+ * replaces an io counter with its growth per second
+ */
+static void rate(uint64_t *value, uint64_t starttime,
+                 const uint64_t *prev, uint64_t prev_timestamp,
+                 uint64_t timestamp) {
+  uint64_t counter = *value;
+  *value = static_cast<uint64_t>(
+    per_ms(counter, starttime, prev, prev_timestamp, timestamp) * 1000);
+}
+
+/**
+ * milliseconds since epoch
+ */
+static inline uint64_t now() {
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+  using std::chrono::system_clock;
+
+  return duration_cast<milliseconds>(
+    system_clock::now().time_since_epoch()).count();
+}
+
+namespace pl {
+
+sampler::sampler()
+: timestamp(0), cores(std::max(1u, std::thread::hardware_concurrency())) {
+}
+
+list_t sampler::sample(const struct process_fields &requested_fields,
+                       const struct list_options &options) {
+  std::lock_guard<std::mutex> guard(lock);
+
+  // fields required to identify processes and compute cpu usage
+  struct process_fields fields = requested_fields;
+  fields.pid = fields.starttime = fields.utime = fields.stime = true;
+
+  list_t proclist = list(fields, options);
+  uint64_t timestamp = now();
+
+  bool io = fields.read_bytes || fields.write_bytes || fields.rchar ||
+    fields.wchar || fields.syscr || fields.syscw;
+
+  std::unordered_map<process_key, counters, process_key_hash> current;
+  current.reserve(proclist.size());
+
+  std::unordered_map<process_key, uint64_t, process_key_hash> threads;
+
+  for (auto &proc : proclist) {
+    process_key key(proc);
+    counters next = {
+      proc.utime + proc.stime, proc.read_bytes, proc.write_bytes,
+      proc.rchar, proc.wchar, proc.syscr, proc.syscw
+    };
+
+    auto it = baseline.find(key);
+    const counters *prev = (it == baseline.end()) ? NULL : &it->second;
+
+    // without a baseline the process is new or it's the first sample,
+    // then the usage is averaged over the whole process lifetime
+    double used = usage(next.cpu, proc.starttime,
+      prev ? &prev->cpu : NULL, this->timestamp, timestamp);
+
+    proc.cpu = NORMAL(used / cores, 0.0, 100.0);
+
+    if (io) {
+      rate(&proc.read_bytes, proc.starttime,
+        prev ? &prev->read_bytes : NULL, this->timestamp, timestamp);
+      rate(&proc.write_bytes, proc.starttime,
+        prev ? &prev->write_bytes : NULL, this->timestamp, timestamp);
+      rate(&proc.rchar, proc.starttime,
+        prev ? &prev->rchar : NULL, this->timestamp, timestamp);
+      rate(&proc.wchar, proc.starttime,
+        prev ? &prev->wchar : NULL, this->timestamp, timestamp);
+      rate(&proc.syscr, proc.starttime,
+        prev ? &prev->syscr : NULL, this->timestamp, timestamp);
+      rate(&proc.syscw, proc.starttime,
+        prev ? &prev->syscw : NULL, this->timestamp, timestamp);
+    }
+
+    current.emplace(key, next);
+
+    // a thread can't use more than one core, so it isn't normalized
+    for (auto &thread : proc.tasks) {
+      process_key tkey(thread.tid, thread.starttime);
+      uint64_t tcpu = thread.utime + thread.stime;
+      auto tprev = thread_cputime.find(tkey);
+
+      used = usage(tcpu, thread.starttime,
+        tprev == thread_cputime.end() ? NULL : &tprev->second,
+        this->timestamp, timestamp);
+
+      thread.cpu = NORMAL(used, 0.0, 100.0);
+      threads.emplace(tkey, tcpu);
+    }
+  }
+
+  baseline.swap(current);
+  thread_cputime.swap(threads);
+  this->timestamp = timestamp;
+
+  return proclist;
+}
+
+}  // namespace pl
@@ -0,0 +1,54 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_SAMPLER_H_
+#define SRC_SAMPLER_H_
+
+#include <stdint.h>
+#include <mutex>  // NOLINT(build/c++11)
+#include <unordered_map>
+
+#include "tasklist.h"  // NOLINT(build/include)
+
+namespace pl {
+
+/**
+ * keeps cpu time and io counters of processes between calls,
+ * so `cpu` is the usage and io fields are the rates per second
+ * over the last interval
+ */
+class sampler {
+ public:
+  sampler();
+
+  /**
+   * read process list, `cpu` is normalized by the number of cores
+   */
+  list_t sample(const struct process_fields &, const struct list_options &);
+
+ private:
+  struct counters {
+    uint64_t cpu;
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+    uint64_t rchar;
+    uint64_t wchar;
+    uint64_t syscr;
+    uint64_t syscw;
+  };
+
+  std::mutex lock;
+  std::unordered_map<process_key, counters, process_key_hash> baseline;
+
+  // keyed by (tid, starttime) of threads
+  std::unordered_map<process_key, uint64_t, process_key_hash> thread_cputime;
+  uint64_t timestamp;
+  uint32_t cores;
+};
+
+}  // namespace pl
+
+#endif  // SRC_SAMPLER_H_
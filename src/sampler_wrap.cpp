@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "sampler_wrap.h"  // NOLINT(build/include)
+
+#include <nan.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "snapshot.h"  // NOLINT(build/include)
+
+using v8::FunctionTemplate;
+using v8::Function;
+using v8::Object;
+using v8::Local;
+using pl::process_fields;
+using pl::list_options;
+
+class SampleWorker : public SnapshotWorker {
+ public:
+  SampleWorker(Nan::Callback *callback,
+               const struct process_fields &fields,
+               const struct list_options &options,
+               const struct output_options &output,
+               pl::sampler *sampler)
+  : SnapshotWorker(callback, fields, options, output), sampler(sampler) {
+  }
+
+ protected:
+  pl::list_t Collect() {
+    return sampler->sample(psfields, psoptions);
+  }
+
+ private:
+  pl::sampler *sampler;
+};
+
+NAN_MODULE_INIT(Sampler::Init) {
+  Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+  tpl->SetClassName(Nan::New("Sampler").ToLocalChecked());
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::SetPrototypeMethod(tpl, "sample", Sample);
+  Nan::SetPrototypeMethod(tpl, "start", Start);
+  Nan::SetPrototypeMethod(tpl, "stop", Stop);
+  Nan::SetPrototypeMethod(tpl, "latest", Latest);
+  Nan::SetPrototypeMethod(tpl, "share", Share);
+
+  Nan::Set(target, Nan::New("Sampler").ToLocalChecked(),
+    Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+Sampler::~Sampler() {
+  // the buffer is released only after the thread is done with it
+  monitor.stop();
+  shared.Reset();
+}
+
+NAN_METHOD(Sampler::New) {
+  if (!info.IsConstructCall()) {
+    return Nan::ThrowTypeError("Class constructor Sampler cannot be invoked "
+      "without 'new'");
+  }
+
+  Sampler *obj = new Sampler();
+  obj->Wrap(info.This());
+
+  info.GetReturnValue().Set(info.This());
+}
+
+NAN_METHOD(Sampler::Sample) {
+  Sampler *obj = Nan::ObjectWrap::Unwrap<Sampler>(info.Holder());
+
+  auto fields = process_fields_from(info[0].As<Object>());
+  auto options = list_options_from(info[1].As<Object>());
+  auto output = output_options_from(info[1].As<Object>());
+  auto *callback = new Nan::Callback(info[2].As<Function>());
+
+  auto *worker = new SampleWorker(callback, fields, options, output,
+    &obj->sampler);
+
+  // keep the sampler alive until the worker is done
+  worker->SaveToPersistent("sampler", info.Holder());
+
+  queue_worker(worker, info[1].As<Object>());
+}
+
+/**
+ * start scanning on the background thread
+ */
+NAN_METHOD(Sampler::Start) {
+  Sampler *obj = Nan::ObjectWrap::Unwrap<Sampler>(info.Holder());
+
+  auto fields = process_fields_from(info[0].As<Object>());
+  auto options = list_options_from(info[1].As<Object>());
+  uint32_t interval = std::max(1u, Nan::To<uint32_t>(info[2]).FromJust());
+
+  obj->fields = fields;
+  obj->output = output_options_from(info[1].As<Object>());
+  obj->monitor.start(fields, options, interval);
+}
+
+NAN_METHOD(Sampler::Stop) {
+  Sampler *obj = Nan::ObjectWrap::Unwrap<Sampler>(info.Holder());
+  obj->monitor.stop();
+}
+
+/**
+ * convert the newest background sample, `null` before the first one.
+ * Throw the error of the last scan if it failed
+ */
+NAN_METHOD(Sampler::Latest) {
+  Sampler *obj = Nan::ObjectWrap::Unwrap<Sampler>(info.Holder());
+  std::string error = obj->monitor.error();
+
+  if (!error.empty()) {
+    return Nan::ThrowError(error.c_str());
+  }
+
+  auto sample = obj->monitor.latest();
+
+  if (!sample) {
+    info.GetReturnValue().SetNull();
+    return;
+  }
+
+  if (!obj->output.columnar) {
+    info.GetReturnValue().Set(
+      to_array(sample->list, obj->fields, obj->output));
+    return;
+  }
+
+  auto columns = pl::to_columns(sample->list, obj->fields, PL_HAS_BIGINT);
+  info.GetReturnValue().Set(to_columns(&columns, obj->fields));
+}
+
+/**
+ * publish background samples to the `SharedArrayBuffer` too
+ */
+NAN_METHOD(Sampler::Share) {
+  Sampler *obj = Nan::ObjectWrap::Unwrap<Sampler>(info.Holder());
+
+  Local<v8::SharedArrayBuffer> buffer = info[0].As<v8::SharedArrayBuffer>();
+  uint32_t capacity = Nan::To<uint32_t>(info[1]).FromJust();
+  uint32_t heap_size = Nan::To<uint32_t>(info[2]).FromJust();
+
+#if V8_MAJOR_VERSION >= 8
+  char *data = static_cast<char *>(buffer->GetBackingStore()->Data());
+  size_t size = buffer->ByteLength();
+#else
+  v8::SharedArrayBuffer::Contents contents = buffer->GetContents();
+  char *data = static_cast<char *>(contents.Data());
+  size_t size = contents.ByteLength();
+#endif
+
+  if (size < pl::shared_table::bytes(capacity, heap_size)) {
+    return Nan::ThrowRangeError("SharedArrayBuffer is too small");
+  }
+
+  obj->monitor.share(std::unique_ptr<pl::shared_table>(
+    new pl::shared_table(data, capacity, heap_size)));
+
+  // the previous buffer isn't written anymore
+  obj->shared.Reset(buffer);
+}
@@ -0,0 +1,45 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_SAMPLER_WRAP_H_
+#define SRC_SAMPLER_WRAP_H_
+
+#include <nan.h>
+
+#include "monitor.h"  // NOLINT(build/include)
+#include "sampler.h"  // NOLINT(build/include)
+#include "snapshot.h"  // NOLINT(build/include)
+
+/**
+ * js binding of `pl::sampler` and its background `pl::monitor`
+ */
+class Sampler : public Nan::ObjectWrap {
+ public:
+  static NAN_MODULE_INIT(Init);
+
+ private:
+  Sampler() {}
+  ~Sampler();
+
+  static NAN_METHOD(New);
+  static NAN_METHOD(Sample);
+  static NAN_METHOD(Start);
+  static NAN_METHOD(Stop);
+  static NAN_METHOD(Latest);
+  static NAN_METHOD(Share);
+
+  pl::sampler sampler;
+
+  // `SharedArrayBuffer` written by the monitor
+  Nan::Persistent<v8::SharedArrayBuffer> shared;
+
+  // background sampling has its own baseline
+  pl::monitor monitor;
+  pl::process_fields fields;
+  output_options output;
+};
+
+#endif  // SRC_SAMPLER_WRAP_H_
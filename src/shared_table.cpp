@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "shared_table.h"  // NOLINT(build/include)
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+/**
+ * words of the header
+ */
+enum header_word {
+  H_MAGIC,
+  H_VERSION,
+  H_SEQUENCE,
+  H_GENERATION,
+  H_CAPACITY,
+  H_HEAP_SIZE,
+  H_LENGTH,
+  H_HEAP_USED,
+  H_FIELDS,
+  H_FLAGS,
+  H_TIMESTAMP  // `double` of words 10 and 11
+};
+
+static const size_t HEADER_SIZE = 64;
+
+/**
+ * columns in the order of the layout
+ */
+enum wide_column {
+  C_STARTTIME,
+  C_CPU,
+  C_VMEM,
+  C_PMEM,
+  C_UTIME,
+  C_STIME,
+  C_PSS,
+  C_USS,
+  C_SWAP,
+  C_SHARED,
+  C_READ_BYTES,
+  C_WRITE_BYTES,
+  C_RCHAR,
+  C_WCHAR,
+  C_SYSCR,
+  C_SYSCW,
+  WIDE_COLUMNS
+};
+
+enum narrow_column {
+  C_PID,
+  C_PPID,
+  C_UID,
+  C_THREADS,
+  C_PRIORITY,
+  C_NAME,  // offset and length of every string
+  C_PATH = C_NAME + 2,
+  C_CMDLINE = C_PATH + 2,
+  C_OWNER = C_CMDLINE + 2,
+  NARROW_COLUMNS = C_OWNER + 2
+};
+
+/**
+ * the sequence is shared with js `Atomics`,
+ * lock-free atomics have the layout of the plain value
+ */
+static std::atomic<uint32_t> *sequence(uint32_t *header) {
+  return reinterpret_cast<std::atomic<uint32_t> *>(header + H_SEQUENCE);
+}
+
+namespace pl {
+
+size_t shared_table::bytes(uint32_t capacity, uint32_t heap_size) {
+  return HEADER_SIZE + capacity * (WIDE_COLUMNS * sizeof(double) +
+    NARROW_COLUMNS * sizeof(uint32_t)) + heap_size;
+}
+
+shared_table::shared_table(char *data, uint32_t capacity, uint32_t heap_size)
+: data(data), capacity(capacity), heap_size(heap_size) {
+  memset(data, 0, bytes(capacity, heap_size));
+
+  uint32_t *header = reinterpret_cast<uint32_t *>(data);
+  header[H_MAGIC] = MAGIC;
+  header[H_VERSION] = VERSION;
+  header[H_CAPACITY] = capacity;
+  header[H_HEAP_SIZE] = heap_size;
+}
+
+template<typename T>
+T *shared_table::column(size_t index, size_t offset) const {
+  return reinterpret_cast<T *>(data + offset + index * capacity * sizeof(T));
+}
+
+void shared_table::publish(const list_t &proclist,
+                           const struct process_fields &fields,
+                           uint64_t timestamp) {
+  uint32_t *header = reinterpret_cast<uint32_t *>(data);
+  uint32_t seq = sequence(header)->load(std::memory_order_relaxed);
+
+  // odd sequence while the table is written
+  sequence(header)->store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  size_t wide_offset = HEADER_SIZE;
+  size_t narrow_offset = wide_offset + capacity * WIDE_COLUMNS * sizeof(double);
+  char *heap = data + narrow_offset +
+    capacity * NARROW_COLUMNS * sizeof(uint32_t);
+
+  uint32_t length = std::min<size_t>(proclist.size(), capacity);
+  uint32_t used = 0;
+  uint32_t flags = (length < proclist.size()) ? TRUNCATED_ROWS : 0;
+
+  auto wide = [this, wide_offset](wide_column index) {
+    return column<double>(index, wide_offset);
+  };
+
+  auto narrow = [this, narrow_offset](size_t index) {
+    return column<uint32_t>(index, narrow_offset);
+  };
+
+  // strings which don't fit the heap are empty
+  auto string = [&heap, &used, &flags, this, &narrow](
+      size_t index, uint32_t row, const string_ref &value) {
+    uint32_t size = value.size;
+
+    if (size > heap_size - used) {
+      size = 0;
+      flags |= TRUNCATED_STRINGS;
+    }
+
+    memcpy(heap + used, value.data, size);
+    narrow(index)[row] = used;
+    narrow(index + 1)[row] = size;
+    used += size;
+  };
+
+  for (uint32_t i = 0; i < length; ++i) {
+    const process &proc = proclist[i];
+
+    wide(C_STARTTIME)[i] = static_cast<double>(proc.starttime);
+    wide(C_CPU)[i] = proc.cpu;
+    wide(C_VMEM)[i] = static_cast<double>(proc.vmem);
+    wide(C_PMEM)[i] = static_cast<double>(proc.pmem);
+    wide(C_UTIME)[i] = static_cast<double>(proc.utime);
+    wide(C_STIME)[i] = static_cast<double>(proc.stime);
+    wide(C_PSS)[i] = static_cast<double>(proc.pss);
+    wide(C_USS)[i] = static_cast<double>(proc.uss);
+    wide(C_SWAP)[i] = static_cast<double>(proc.swap);
+    wide(C_SHARED)[i] = static_cast<double>(proc.shared);
+    wide(C_READ_BYTES)[i] = static_cast<double>(proc.read_bytes);
+    wide(C_WRITE_BYTES)[i] = static_cast<double>(proc.write_bytes);
+    wide(C_RCHAR)[i] = static_cast<double>(proc.rchar);
+    wide(C_WCHAR)[i] = static_cast<double>(proc.wchar);
+    wide(C_SYSCR)[i] = static_cast<double>(proc.syscr);
+    wide(C_SYSCW)[i] = static_cast<double>(proc.syscw);
+
+    narrow(C_PID)[i] = proc.pid;
+    narrow(C_PPID)[i] = proc.ppid;
+    narrow(C_UID)[i] = proc.uid;
+    narrow(C_THREADS)[i] = proc.threads;
+    reinterpret_cast<int32_t *>(narrow(C_PRIORITY))[i] = proc.priority;
+
+    string(C_NAME, i, proc.name);
+    string(C_PATH, i, proc.path);
+    string(C_CMDLINE, i, proc.cmdline);
+    string(C_OWNER, i, proc.owner);
+  }
+
+  // bits of the mask are in the order of `FIELDS` of `shared.js`
+  bool bits[] = {
+    fields.pid, fields.ppid, fields.uid, fields.threads, fields.priority,
+    fields.starttime, fields.cpu, fields.vmem, fields.pmem, fields.utime,
+    fields.stime, fields.pss, fields.uss, fields.swap, fields.shared,
+    fields.read_bytes, fields.write_bytes, fields.rchar, fields.wchar,
+    fields.syscr, fields.syscw,
+    fields.name, fields.path, fields.cmdline, fields.owner
+  };
+
+  uint32_t mask = 0;
+
+  for (size_t bit = 0; bit < sizeof(bits) / sizeof(bits[0]); ++bit) {
+    mask |= bits[bit] ? (1u << bit) : 0;
+  }
+
+  double time = static_cast<double>(timestamp);
+
+  header[H_GENERATION] += 1;
+  header[H_LENGTH] = length;
+  header[H_HEAP_USED] = used;
+  header[H_FIELDS] = mask;
+  header[H_FLAGS] = flags;
+  memcpy(header + H_TIMESTAMP, &time, sizeof(time));
+
+  sequence(header)->store(seq + 2, std::memory_order_release);
+}
+
+}  // namespace pl
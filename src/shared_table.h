@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_SHARED_TABLE_H_
+#define SRC_SHARED_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tasklist.h"  // NOLINT(build/include)
+
+namespace pl {
+
+/**
+ * process list in the fixed layout of `shared.js`, it's written to
+ * a `SharedArrayBuffer` by one producer and read by js threads without
+ * locks. Readers retry when the sequence is odd or has changed.
+ *
+ * header, 64 bytes of `uint32_t`:
+ *   magic, version, sequence, generation, capacity, heap size,
+ *   length, used heap, mask of fields, flags, timestamp (`double`)
+ * then `capacity` rows of every column:
+ *   `double` starttime, cpu, vmem, pmem, utime, stime, pss, uss, swap,
+ *     shared, read bytes, write bytes, rchar, wchar, syscr, syscw;
+ *   `uint32_t` pid, ppid, uid, threads; `int32_t` priority;
+ *   `uint32_t` offset and length of name, path, cmdline, owner
+ * then the heap of utf-8 strings
+ */
+class shared_table {
+ public:
+  static const uint32_t MAGIC = 0x504c5354;
+  static const uint32_t VERSION = 1;
+
+  // rows or strings didn't fit
+  static const uint32_t TRUNCATED_ROWS = 1;
+  static const uint32_t TRUNCATED_STRINGS = 2;
+
+  /**
+   * size of the buffer for the table
+   */
+  static size_t bytes(uint32_t capacity, uint32_t heap_size);
+
+  /**
+   * format the buffer of at least `bytes()`, it should be 8-byte aligned
+   */
+  shared_table(char *data, uint32_t capacity, uint32_t heap_size);
+
+  /**
+   * write the list, only requested fields are marked as valid
+   */
+  void publish(const list_t &, const struct process_fields &,
+               uint64_t timestamp);
+
+ private:
+  template<typename T>
+  T *column(size_t index, size_t offset) const;
+
+  char *data;
+  uint32_t capacity;
+  uint32_t heap_size;
+};
+
+}  // namespace pl
+
+#endif  // SRC_SHARED_TABLE_H_
@@ -8,10 +8,16 @@
 
 #include <nan.h>
 
+#include <string.h>
+
 #include <algorithm>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
-#include "tasklist.h"  // NOLINT(build/include)
+#include "executor.h"  // NOLINT(build/include)
+#include "metadata.h"  // NOLINT(build/include)
 
 using v8::Number;
 using v8::String;
@@ -23,143 +29,896 @@ using v8::Local;
 using v8::Value;
 using v8::Date;
 using pl::process_fields;
+using pl::list_options;
 
 #define STR(s) Nan::New<v8::String>(s).ToLocalChecked()
 
 #define PROP_BOOL(obj, prop) \
   Nan::To<bool>(Nan::Get(obj, STR(prop)).ToLocalChecked()).FromJust()
 
-class SnapshotWorker : public Nan::AsyncWorker {
- public:
-  SnapshotWorker(Nan::Callback *callback, const struct process_fields &fields)
-  : Nan::AsyncWorker(callback), psfields(fields) {
+#define PROP_UINT(obj, prop) \
+  Nan::To<uint32_t>(Nan::Get(obj, STR(prop)).ToLocalChecked()).FromJust()
+
+SnapshotWorker::SnapshotWorker(Nan::Callback *callback,
+                               const struct process_fields &fields,
+                               const struct list_options &options,
+                               const struct output_options &output)
+: Nan::AsyncWorker(callback),
+  psfields(fields), psoptions(options), psoutput(output) {
+  if (psoutput.stats) {
+    psoptions.stats = &stats;
+  }
+}
+
+pl::list_t SnapshotWorker::Collect() {
+  return pl::list(psfields, psoptions);
+}
+
+void SnapshotWorker::Execute() {
+  try {
+    {
+      pl::probe measure(psoptions.stats, pl::PHASE_SCAN);
+      tasks = Collect();
+    }
+
+    if (psoptions.stats) {
+      pl::record(stats);
+    }
+
+    // fill columns here, so the main thread only wraps them
+    if (psoutput.columnar) {
+      columns = pl::to_columns(tasks, psfields, PL_HAS_BIGINT);
+      pl::list_t().swap(tasks);
+    }
+  } catch(const std::exception &e) {
+    SetErrorMessage(e.what());
+  }
+}
+
+/**
+ * property names of the process object, in the order of output
+ */
+enum field_key {
+  KEY_NAME,
+  KEY_PID,
+  KEY_PPID,
+  KEY_PATH,
+  KEY_THREADS,
+  KEY_OWNER,
+  KEY_UID,
+  KEY_PRIORITY,
+  KEY_CMDLINE,
+  KEY_STARTTIME,
+  KEY_VMEM,
+  KEY_PMEM,
+  KEY_CPU,
+  KEY_UTIME,
+  KEY_STIME,
+  KEY_PSS,
+  KEY_USS,
+  KEY_SWAP,
+  KEY_SHARED,
+  KEY_READ_BYTES,
+  KEY_WRITE_BYTES,
+  KEY_RCHAR,
+  KEY_WCHAR,
+  KEY_SYSCR,
+  KEY_SYSCW,
+  KEY_TASKS,
+
+  // properties of threads
+  KEY_TID,
+  KEY_STATE,
+  KEYS_COUNT
+};
+
+static const char *key_names[KEYS_COUNT] = {
+  "name",
+  "pid",
+  "ppid",
+  "path",
+  "threads",
+  "owner",
+  "uid",
+  "priority",
+  "cmdline",
+  "starttime",
+  "vmem",
+  "pmem",
+  "cpu",
+  "utime",
+  "stime",
+  "pss",
+  "uss",
+  "swap",
+  "shared",
+  "readBytes",
+  "writeBytes",
+  "rchar",
+  "wchar",
+  "syscr",
+  "syscw",
+  "tasks",
+  "tid",
+  "state"
+};
+
+/**
+ * internalized property names, created once at module init
+ */
+static Nan::Persistent<String> keys[KEYS_COUNT];
+
+void init_keys() {
+  for (int i = 0; i < KEYS_COUNT; ++i) {
+    keys[i].Reset(String::NewFromUtf8(v8::Isolate::GetCurrent(), key_names[i],
+      v8::NewStringType::kInternalized).ToLocalChecked());
+  }
+}
+
+static inline Local<String> key(field_key k) {
+  return Nan::New(keys[k]);
+}
+
+/**
+ * string of the process without a copy to `std::string`
+ */
+static inline Local<String> str(const pl::string_ref &value) {
+  return Nan::New<String>(value.data, value.size).ToLocalChecked();
+}
+
+/**
+ * check if the field of the key is requested
+ */
+static bool requested(const struct process_fields &psfields, field_key k) {
+  switch (k) {
+    case KEY_NAME: return psfields.name;
+    case KEY_PID: return psfields.pid;
+    case KEY_PPID: return psfields.ppid;
+    case KEY_PATH: return psfields.path;
+    case KEY_THREADS: return psfields.threads;
+    case KEY_OWNER: return psfields.owner;
+    case KEY_UID: return psfields.uid;
+    case KEY_PRIORITY: return psfields.priority;
+    case KEY_CMDLINE: return psfields.cmdline;
+    case KEY_STARTTIME: return psfields.starttime;
+    case KEY_VMEM: return psfields.vmem;
+    case KEY_PMEM: return psfields.pmem;
+    case KEY_CPU: return psfields.cpu;
+    case KEY_UTIME: return psfields.utime;
+    case KEY_STIME: return psfields.stime;
+    case KEY_PSS: return psfields.pss;
+    case KEY_USS: return psfields.uss;
+    case KEY_SWAP: return psfields.swap;
+    case KEY_SHARED: return psfields.shared;
+    case KEY_READ_BYTES: return psfields.read_bytes;
+    case KEY_WRITE_BYTES: return psfields.write_bytes;
+    case KEY_RCHAR: return psfields.rchar;
+    case KEY_WCHAR: return psfields.wchar;
+    case KEY_SYSCR: return psfields.syscr;
+    case KEY_SYSCW: return psfields.syscw;
+    case KEY_TASKS: return psfields.tasks;
+    default: return false;
+  }
+}
+
+typedef Nan::Persistent<v8::ObjectTemplate> persistent_template;
+
+/**
+ * templates of process objects by the mask of requested keys,
+ * applications use a few field sets, so the cache is small
+ */
+static std::map<uint64_t, std::unique_ptr<persistent_template>> templates;
+static const size_t MAX_TEMPLATES = 64;
+
+/**
+ * template with all requested properties, so every process object
+ * is created with the final shape instead of growing property by property.
+ * It's built once per set of fields
+ */
+static Local<v8::ObjectTemplate> process_template(
+    const struct process_fields &psfields) {
+  static_assert(KEYS_COUNT <= 64, "keys don't fit the mask");
+  uint64_t mask = 0;
+
+  for (int i = 0; i < KEYS_COUNT; ++i) {
+    if (requested(psfields, static_cast<field_key>(i))) {
+      mask |= 1ull << i;
+    }
+  }
+
+  auto cached = templates.find(mask);
+
+  if (cached != templates.end()) {
+    return Nan::New(*cached->second);
   }
 
-  ~SnapshotWorker() {}
+  Nan::EscapableHandleScope scope;
+  Local<v8::ObjectTemplate> tpl = Nan::New<v8::ObjectTemplate>();
 
-  void Execute() {
-    try {
-      tasks = pl::list(psfields);
-    } catch(const std::exception &e) {
-      SetErrorMessage(e.what());
+  for (int i = 0; i < KEYS_COUNT; ++i) {
+    if (mask & (1ull << i)) {
+      tpl->Set(key(static_cast<field_key>(i)), Nan::Undefined());
     }
   }
 
-  void HandleOKCallback() {
-    Nan::HandleScope scope;
+  if (templates.size() < MAX_TEMPLATES) {
+    templates[mask].reset(new persistent_template(tpl));
+  }
+
+  return scope.Escape(tpl);
+}
+
+/**
+ * max integer represented by `double` without precision loss
+ */
+static const uint64_t MAX_SAFE_INTEGER = (1ull << 53) - 1;
+
+Local<Value> wide(uint64_t value, numeric_mode mode) {
+#if PL_HAS_BIGINT
+  if (mode == NUMERIC_BIGINT ||
+      (mode == NUMERIC_NUMBER && value > MAX_SAFE_INTEGER)) {
+    return v8::BigInt::NewFromUnsigned(v8::Isolate::GetCurrent(), value);
+  }
+#endif
+
+  if (mode == NUMERIC_STRING) {
+    return STR(std::to_string(value));
+  }
+
+  return Nan::New<Number>(static_cast<double>(value));
+}
+
+Local<Array> to_array(const pl::list_t &tasks,
+                      const struct process_fields &psfields,
+                      const struct output_options &output) {
+  return to_array(tasks.data(), tasks.size(), psfields, output);
+}
+
+/**
+ * template of thread objects
+ */
+static Local<v8::ObjectTemplate> thread_template() {
+  static const field_key thread_keys[] = {
+    KEY_TID, KEY_NAME, KEY_STATE, KEY_STARTTIME, KEY_CPU, KEY_UTIME, KEY_STIME
+  };
+  static persistent_template cached;
+
+  if (!cached.IsEmpty()) {
+    return Nan::New(cached);
+  }
+
+  Nan::EscapableHandleScope scope;
+  Local<v8::ObjectTemplate> tpl = Nan::New<v8::ObjectTemplate>();
+
+  for (field_key k : thread_keys) {
+    tpl->Set(key(k), Nan::Undefined());
+  }
+
+  cached.Reset(tpl);
+  return scope.Escape(tpl);
+}
+
+/**
+ * object with the shape of the template, an empty template is
+ * the baseline of adding properties one by one
+ */
+static inline Local<Object> new_object(Local<v8::ObjectTemplate> tpl) {
+  if (tpl.IsEmpty()) {
+    return Nan::New<Object>();
+  }
+
+  return Nan::NewInstance(tpl).ToLocalChecked();
+}
+
+/**
+ * convert threads of the process to js array
+ */
+static Local<Array> to_threads(const std::vector<pl::thread_info> &threads,
+                               Local<v8::ObjectTemplate> tpl,
+                               numeric_mode numeric) {
+  Local<Array> list = Nan::New<Array>(threads.size());
+
+  for (uint32_t i = 0; i < threads.size(); ++i) {
+    const pl::thread_info &thread = threads[i];
+    Local<Object> hash = new_object(tpl);
+
+    Nan::Set(hash, key(KEY_TID), Nan::New<Number>(thread.tid));
+    Nan::Set(hash, key(KEY_NAME), STR(thread.name));
+    Nan::Set(hash, key(KEY_STATE), STR(std::string(1, thread.state)));
+    Nan::Set(hash, key(KEY_STARTTIME),
+      Nan::New<Date>(thread.starttime).ToLocalChecked());
+    Nan::Set(hash, key(KEY_CPU), Nan::New<Number>(thread.cpu));
+    Nan::Set(hash, key(KEY_UTIME), wide(thread.utime, numeric));
+    Nan::Set(hash, key(KEY_STIME), wide(thread.stime, numeric));
+
+    Nan::Set(list, i, hash);
+  }
+
+  return list;
+}
+
+Local<Array> to_array(const pl::process *tasks, size_t count,
+                      const struct process_fields &psfields,
+                      const struct output_options &output) {
+  Nan::EscapableHandleScope scope;
+
+  Local<Array> jobs = Nan::New<Array>(count);
+  Local<v8::ObjectTemplate> tpl;
+  Local<v8::ObjectTemplate> thread_tpl;
+
+  if (output.templates) {
+    tpl = process_template(psfields);
+  }
+
+  if (output.templates && psfields.tasks) {
+    thread_tpl = thread_template();
+  }
+
+  for (uint32_t i = 0; i < jobs->Length(); ++i) {
+    const pl::process &task = tasks[i];
+    Local<Object> hash = new_object(tpl);
+
+    if (psfields.name) {
+      Nan::Set(hash, key(KEY_NAME), str(task.name));
+    }
+
+    if (psfields.pid) {
+      Nan::Set(hash, key(KEY_PID), Nan::New<Number>(task.pid));
+    }
+
+    if (psfields.ppid) {
+      Nan::Set(hash, key(KEY_PPID), Nan::New<Number>(task.ppid));
+    }
+
+    if (psfields.path) {
+      Nan::Set(hash, key(KEY_PATH), str(task.path));
+    }
+
+    if (psfields.threads) {
+      Nan::Set(hash, key(KEY_THREADS), Nan::New<Number>(task.threads));
+    }
 
-    Local<Array> jobs = Nan::New<Array>(tasks.size());
+    if (psfields.owner) {
+      Nan::Set(hash, key(KEY_OWNER), str(task.owner));
+    }
+
+    if (psfields.uid) {
+      Nan::Set(hash, key(KEY_UID), Nan::New<Number>(task.uid));
+    }
+
+    if (psfields.priority) {
+      Nan::Set(hash, key(KEY_PRIORITY), Nan::New<Number>(task.priority));
+    }
+
+    if (psfields.cmdline) {
+      Nan::Set(hash, key(KEY_CMDLINE), str(task.cmdline));
+    }
 
-    for (uint32_t i = 0; i < jobs->Length(); ++i) {
-      Local<Object> hash = Nan::New<Object>();
+    if (psfields.starttime) {
+      Nan::Set(hash, key(KEY_STARTTIME),
+        Nan::New<Date>(task.starttime).ToLocalChecked());
+    }
 
-      if (psfields.name) {
-        Nan::Set(hash, STR("name"), STR(tasks.at(i).name));
-      }
+    if (psfields.vmem) {
+      Nan::Set(hash, key(KEY_VMEM), wide(task.vmem, output.numeric));
+    }
 
-      if (psfields.pid) {
-        Nan::Set(hash, STR("pid"), Nan::New<Number>(tasks.at(i).pid));
-      }
+    if (psfields.pmem) {
+      Nan::Set(hash, key(KEY_PMEM), wide(task.pmem, output.numeric));
+    }
 
-      if (psfields.ppid) {
-        Nan::Set(hash, STR("ppid"), Nan::New<Number>(tasks.at(i).ppid));
-      }
+    if (psfields.cpu) {
+      Nan::Set(hash, key(KEY_CPU), Nan::New<Number>(task.cpu));
+    }
 
-      if (psfields.path) {
-        Nan::Set(hash, STR("path"), STR(tasks.at(i).path));
-      }
+    if (psfields.utime) {
+      Nan::Set(hash, key(KEY_UTIME), wide(task.utime, output.numeric));
+    }
 
-      if (psfields.threads) {
-        Nan::Set(hash, STR("threads"),
-          Nan::New<Number>(tasks.at(i).threads));
-      }
+    if (psfields.stime) {
+      Nan::Set(hash, key(KEY_STIME), wide(task.stime, output.numeric));
+    }
 
-      if (psfields.owner) {
-        Nan::Set(hash, STR("owner"), STR(tasks.at(i).owner));
-      }
+    if (psfields.pss) {
+      Nan::Set(hash, key(KEY_PSS), wide(task.pss, output.numeric));
+    }
 
-      if (psfields.priority) {
-        Nan::Set(hash, STR("priority"),
-          Nan::New<Number>(tasks.at(i).priority));
-      }
+    if (psfields.uss) {
+      Nan::Set(hash, key(KEY_USS), wide(task.uss, output.numeric));
+    }
 
-      if (psfields.cmdline) {
-        Nan::Set(hash, STR("cmdline"), STR(tasks.at(i).cmdline));
-      }
+    if (psfields.swap) {
+      Nan::Set(hash, key(KEY_SWAP), wide(task.swap, output.numeric));
+    }
 
-      if (psfields.starttime) {
-        Nan::Set(hash, STR("starttime"),
-          Nan::New<Date>(tasks.at(i).starttime).ToLocalChecked());
-      }
+    if (psfields.shared) {
+      Nan::Set(hash, key(KEY_SHARED), wide(task.shared, output.numeric));
+    }
 
-      if (psfields.vmem) {
-        Nan::Set(hash, STR("vmem"), STR(std::to_string(tasks.at(i).vmem)));
-      }
+    if (psfields.read_bytes) {
+      Nan::Set(hash, key(KEY_READ_BYTES),
+        wide(task.read_bytes, output.numeric));
+    }
 
-      if (psfields.pmem) {
-        Nan::Set(hash, STR("pmem"), STR(std::to_string(tasks.at(i).pmem)));
-      }
+    if (psfields.write_bytes) {
+      Nan::Set(hash, key(KEY_WRITE_BYTES),
+        wide(task.write_bytes, output.numeric));
+    }
 
-      if (psfields.cpu) {
-        Nan::Set(hash, STR("cpu"),
-          Nan::New<Number>(tasks.at(i).cpu));
-      }
+    if (psfields.rchar) {
+      Nan::Set(hash, key(KEY_RCHAR), wide(task.rchar, output.numeric));
+    }
 
-      if (psfields.utime) {
-        Nan::Set(hash, STR("utime"), STR(std::to_string(tasks.at(i).utime)));
-      }
+    if (psfields.wchar) {
+      Nan::Set(hash, key(KEY_WCHAR), wide(task.wchar, output.numeric));
+    }
 
-      if (psfields.stime) {
-        Nan::Set(hash, STR("stime"), STR(std::to_string(tasks.at(i).stime)));
-      }
+    if (psfields.syscr) {
+      Nan::Set(hash, key(KEY_SYSCR), wide(task.syscr, output.numeric));
+    }
 
-      Nan::Set(jobs, i, hash);
+    if (psfields.syscw) {
+      Nan::Set(hash, key(KEY_SYSCW), wide(task.syscw, output.numeric));
     }
 
-    Local<Value> argv[] = {
-      Nan::Null(),
-      jobs
-    };
+    if (psfields.tasks) {
+      Nan::Set(hash, key(KEY_TASKS),
+        to_threads(task.tasks, thread_tpl, output.numeric));
+    }
 
-    callback->Call(2, argv, async_resource);
+    Nan::Set(jobs, i, hash);
   }
 
-  void HandleErrorCallback() {
-    Nan::HandleScope scope;
+  return scope.Escape(jobs);
+}
+
+void attach_stats(Local<Value> result, const pl::scan_stats &stats) {
+  pl::record(pl::PHASE_CONVERT, stats.phases[pl::PHASE_CONVERT]);
 
-    Local<Value> argv[] = {
-      Nan::Error(ErrorMessage())
-    };
+  Nan::DefineOwnProperty(result.As<Object>(), STR("stats"), to_stats(stats),
+    v8::DontEnum);
+}
+
+void SnapshotWorker::HandleOKCallback() {
+  Nan::HandleScope scope;
+
+  Local<Value> result;
 
-    callback->Call(1, argv, async_resource);
+  {
+    pl::probe measure(psoptions.stats, pl::PHASE_CONVERT);
+    result = psoutput.columnar ?
+      Local<Value>(to_columns(&columns, psfields)) :
+      Local<Value>(to_array(tasks, psfields, psoutput));
   }
 
- private:
-  pl::list_t tasks;
-  process_fields psfields;
-};
+  if (psoptions.stats) {
+    attach_stats(result, stats);
+  }
 
-NAN_METHOD(snapshot) {
-  auto arg0 = info[0].As<Object>();
+  Local<Value> argv[] = {
+    Nan::Null(),
+    result
+  };
+
+  callback->Call(2, argv, async_resource);
+}
+
+static void free_column(char *data, void *) {
+  free(data);
+}
+
+/**
+ * wrap column memory to the typed array without copy
+ */
+template<class TypedArray>
+static Local<TypedArray> typed_array(pl::column *column, size_t length) {
+  size_t size = column->size;
+  Local<Object> buffer = Nan::NewBuffer(column->release(), size,
+    free_column, NULL).ToLocalChecked();
+
+  return TypedArray::New(buffer.As<v8::Uint8Array>()->Buffer(), 0, length);
+}
+
+static Local<Object> string_column(pl::string_column *column, size_t length) {
+  Local<Object> strings = Nan::New<Object>();
+  size_t size = column->data.size;
 
+  Nan::Set(strings, STR("offsets"),
+    typed_array<v8::Uint32Array>(&column->offsets, length + 1));
+  Nan::Set(strings, STR("data"), Nan::NewBuffer(column->data.release(), size,
+    free_column, NULL).ToLocalChecked());
+
+  return strings;
+}
+
+Local<Object> to_columns(pl::columns *columns,
+                         const struct process_fields &psfields) {
+  Nan::EscapableHandleScope scope;
+
+  Local<Object> result = Nan::New<Object>();
+  size_t length = columns->length;
+
+#if PL_HAS_BIGINT
+  typedef v8::BigUint64Array WideArray;
+#else
+  typedef v8::Float64Array WideArray;
+#endif
+
+  Nan::Set(result, STR("length"), Nan::New<Number>(length));
+
+  if (psfields.name) {
+    Nan::Set(result, STR("name"), string_column(&columns->name, length));
+  }
+
+  if (psfields.pid) {
+    Nan::Set(result, STR("pid"),
+      typed_array<v8::Uint32Array>(&columns->pid, length));
+  }
+
+  if (psfields.ppid) {
+    Nan::Set(result, STR("ppid"),
+      typed_array<v8::Uint32Array>(&columns->ppid, length));
+  }
+
+  if (psfields.path) {
+    Nan::Set(result, STR("path"), string_column(&columns->path, length));
+  }
+
+  if (psfields.threads) {
+    Nan::Set(result, STR("threads"),
+      typed_array<v8::Uint32Array>(&columns->threads, length));
+  }
+
+  if (psfields.owner) {
+    Nan::Set(result, STR("owner"), string_column(&columns->owner, length));
+  }
+
+  if (psfields.uid) {
+    Nan::Set(result, STR("uid"),
+      typed_array<v8::Uint32Array>(&columns->uid, length));
+  }
+
+  if (psfields.priority) {
+    Nan::Set(result, STR("priority"),
+      typed_array<v8::Int32Array>(&columns->priority, length));
+  }
+
+  if (psfields.cmdline) {
+    Nan::Set(result, STR("cmdline"),
+      string_column(&columns->cmdline, length));
+  }
+
+  if (psfields.starttime) {
+    Nan::Set(result, STR("starttime"),
+      typed_array<v8::Float64Array>(&columns->starttime, length));
+  }
+
+  if (psfields.vmem) {
+    Nan::Set(result, STR("vmem"),
+      typed_array<WideArray>(&columns->vmem, length));
+  }
+
+  if (psfields.pmem) {
+    Nan::Set(result, STR("pmem"),
+      typed_array<WideArray>(&columns->pmem, length));
+  }
+
+  if (psfields.cpu) {
+    Nan::Set(result, STR("cpu"),
+      typed_array<v8::Float64Array>(&columns->cpu, length));
+  }
+
+  if (psfields.utime) {
+    Nan::Set(result, STR("utime"),
+      typed_array<WideArray>(&columns->utime, length));
+  }
+
+  if (psfields.stime) {
+    Nan::Set(result, STR("stime"),
+      typed_array<WideArray>(&columns->stime, length));
+  }
+
+  if (psfields.pss) {
+    Nan::Set(result, STR("pss"),
+      typed_array<WideArray>(&columns->pss, length));
+  }
+
+  if (psfields.uss) {
+    Nan::Set(result, STR("uss"),
+      typed_array<WideArray>(&columns->uss, length));
+  }
+
+  if (psfields.swap) {
+    Nan::Set(result, STR("swap"),
+      typed_array<WideArray>(&columns->swap, length));
+  }
+
+  if (psfields.shared) {
+    Nan::Set(result, STR("shared"),
+      typed_array<WideArray>(&columns->shared, length));
+  }
+
+  if (psfields.read_bytes) {
+    Nan::Set(result, STR("readBytes"),
+      typed_array<WideArray>(&columns->read_bytes, length));
+  }
+
+  if (psfields.write_bytes) {
+    Nan::Set(result, STR("writeBytes"),
+      typed_array<WideArray>(&columns->write_bytes, length));
+  }
+
+  if (psfields.rchar) {
+    Nan::Set(result, STR("rchar"),
+      typed_array<WideArray>(&columns->rchar, length));
+  }
+
+  if (psfields.wchar) {
+    Nan::Set(result, STR("wchar"),
+      typed_array<WideArray>(&columns->wchar, length));
+  }
+
+  if (psfields.syscr) {
+    Nan::Set(result, STR("syscr"),
+      typed_array<WideArray>(&columns->syscr, length));
+  }
+
+  if (psfields.syscw) {
+    Nan::Set(result, STR("syscw"),
+      typed_array<WideArray>(&columns->syscw, length));
+  }
+
+  return scope.Escape(result);
+}
+
+void SnapshotWorker::HandleErrorCallback() {
+  Nan::HandleScope scope;
+
+  Local<Value> argv[] = {
+    Nan::Error(ErrorMessage())
+  };
+
+  callback->Call(1, argv, async_resource);
+}
+
+static Local<Object> to_phase(const pl::phase_stats &phase) {
+  Local<Object> obj = Nan::New<Object>();
+
+  Nan::Set(obj, STR("calls"), Nan::New<Number>(phase.calls));
+  Nan::Set(obj, STR("wall"), Nan::New<Number>(phase.wall));
+  Nan::Set(obj, STR("cpu"), Nan::New<Number>(phase.cpu));
+  Nan::Set(obj, STR("syscalls"), Nan::New<Number>(phase.syscalls));
+  Nan::Set(obj, STR("bytes"), Nan::New<Number>(phase.bytes));
+
+  return obj;
+}
+
+Local<Object> to_stats(const pl::scan_stats &stats) {
+  Nan::EscapableHandleScope scope;
+
+  Local<Object> result = Nan::New<Object>();
+  Local<Object> phases = Nan::New<Object>();
+
+  Nan::Set(result, STR("processes"), Nan::New<Number>(stats.processes));
+  Nan::Set(result, STR("skipped"), Nan::New<Number>(stats.skipped));
+  Nan::Set(result, STR("vanished"), Nan::New<Number>(stats.vanished));
+
+  // only measured phases are reported
+  for (size_t i = 0; i < pl::PHASE_COUNT; ++i) {
+    if (stats.phases[i].calls != 0) {
+      Nan::Set(phases, STR(pl::phase_names[i]), to_phase(stats.phases[i]));
+    }
+  }
+
+  Nan::Set(result, STR("phases"), phases);
+  return scope.Escape(result);
+}
+
+struct process_fields process_fields_from(Local<Object> obj) {
   struct process_fields fields = {
-    PROP_BOOL(arg0, "pid"),
-    PROP_BOOL(arg0, "ppid"),
-    PROP_BOOL(arg0, "path"),
-    PROP_BOOL(arg0, "name"),
-    PROP_BOOL(arg0, "owner"),
-    PROP_BOOL(arg0, "cmdline"),
-    PROP_BOOL(arg0, "threads"),
-    PROP_BOOL(arg0, "priority"),
-    PROP_BOOL(arg0, "starttime"),
-    PROP_BOOL(arg0, "vmem"),
-    PROP_BOOL(arg0, "pmem"),
-    PROP_BOOL(arg0, "cpu"),
-    PROP_BOOL(arg0, "utime"),
-    PROP_BOOL(arg0, "stime")
+    PROP_BOOL(obj, "pid"),
+    PROP_BOOL(obj, "ppid"),
+    PROP_BOOL(obj, "path"),
+    PROP_BOOL(obj, "name"),
+    PROP_BOOL(obj, "owner"),
+    PROP_BOOL(obj, "uid"),
+    PROP_BOOL(obj, "cmdline"),
+    PROP_BOOL(obj, "threads"),
+    PROP_BOOL(obj, "priority"),
+    PROP_BOOL(obj, "starttime"),
+    PROP_BOOL(obj, "vmem"),
+    PROP_BOOL(obj, "pmem"),
+    PROP_BOOL(obj, "cpu"),
+    PROP_BOOL(obj, "utime"),
+    PROP_BOOL(obj, "stime"),
+    PROP_BOOL(obj, "pss"),
+    PROP_BOOL(obj, "uss"),
+    PROP_BOOL(obj, "swap"),
+    PROP_BOOL(obj, "shared"),
+    PROP_BOOL(obj, "readBytes"),
+    PROP_BOOL(obj, "writeBytes"),
+    PROP_BOOL(obj, "rchar"),
+    PROP_BOOL(obj, "wchar"),
+    PROP_BOOL(obj, "syscr"),
+    PROP_BOOL(obj, "syscw"),
+    PROP_BOOL(obj, "tasks")
   };
 
-  auto *callback = new Nan::Callback(info[1].As<Function>());
+  return fields;
+}
+
+/**
+ * read `filter` option, missing properties match any process
+ */
+static struct pl::process_filter filter_from(Local<Value> value) {
+  struct pl::process_filter filter;
+
+  if (!value->IsObject()) {
+    return filter;
+  }
+
+  Local<Object> obj = value.As<Object>();
+  Local<Value> pids = Nan::Get(obj, STR("pids")).ToLocalChecked();
+
+  if (pids->IsArray()) {
+    Local<Array> list = pids.As<Array>();
+
+    for (uint32_t i = 0; i < list->Length(); ++i) {
+      Local<Value> pid = Nan::Get(list, i).ToLocalChecked();
+      filter.pids.push_back(Nan::To<uint32_t>(pid).FromJust());
+    }
+
+    std::sort(filter.pids.begin(), filter.pids.end());
+    filter.pids.erase(std::unique(filter.pids.begin(), filter.pids.end()),
+      filter.pids.end());
+  }
+
+  filter.has_ppid = !Nan::Get(obj, STR("ppid")).ToLocalChecked()->IsUndefined();
+  filter.ppid = filter.has_ppid ? PROP_UINT(obj, "ppid") : 0;
+
+  filter.has_uid = !Nan::Get(obj, STR("uid")).ToLocalChecked()->IsUndefined();
+  filter.uid = filter.has_uid ? PROP_UINT(obj, "uid") : 0;
+
+  Local<Value> owner = Nan::Get(obj, STR("owner")).ToLocalChecked();
+
+  if (owner->IsString()) {
+    filter.owner = *Nan::Utf8String(owner);
+  }
+
+  Local<Value> name = Nan::Get(obj, STR("name")).ToLocalChecked();
+
+  if (name->IsString()) {
+    filter.name = *Nan::Utf8String(name);
+  }
+
+  return filter;
+}
+
+struct list_options list_options_from(Local<Object> obj) {
+  struct list_options options;
+  options.concurrency = std::max(1u, PROP_UINT(obj, "concurrency"));
+  options.owner_ttl = PROP_UINT(obj, "ownerCacheTtl");
+  options.cache_size = PROP_UINT(obj, "metadataCache");
+  options.filter = filter_from(Nan::Get(obj, STR("filter")).ToLocalChecked());
+
+  Local<Value> procfs = Nan::Get(obj, STR("procfs")).ToLocalChecked();
+
+  if (procfs->IsString()) {
+    options.procfs = *Nan::Utf8String(procfs);
+  }
+
+  return options;
+}
+
+struct output_options output_options_from(Local<Object> obj) {
+  struct output_options output;
+  output.columnar = PROP_BOOL(obj, "columnar");
+  output.stats = PROP_BOOL(obj, "stats");
+  // undocumented, only `bench/convert.js` disables templates
+  output.templates =
+    !Nan::Get(obj, STR("objectTemplates")).ToLocalChecked()->IsFalse();
+
+  Nan::Utf8String numeric(Nan::Get(obj, STR("numeric")).ToLocalChecked());
+
+  if (!strcmp(*numeric, "number")) {
+    output.numeric = NUMERIC_NUMBER;
+  } else if (!strcmp(*numeric, "bigint")) {
+    output.numeric = NUMERIC_BIGINT;
+  }
+
+  return output;
+}
+
+void queue_worker(Nan::AsyncWorker *worker, Local<Object> obj) {
+  Nan::Utf8String executor(Nan::Get(obj, STR("executor")).ToLocalChecked());
+
+  if (!strcmp(*executor, "dedicated")) {
+    DedicatedQueueWorker(worker);
+  } else {
+    Nan::AsyncQueueWorker(worker);
+  }
+}
+
+NAN_METHOD(snapshot) {
+  auto fields = process_fields_from(info[0].As<Object>());
+  auto options = list_options_from(info[1].As<Object>());
+  auto output = output_options_from(info[1].As<Object>());
+  auto *callback = new Nan::Callback(info[2].As<Function>());
+
+  queue_worker(new SnapshotWorker(callback, fields, options, output),
+    info[1].As<Object>());
+}
+
+NAN_METHOD(snapshotSync) {
+  auto fields = process_fields_from(info[0].As<Object>());
+  auto options = list_options_from(info[1].As<Object>());
+  auto output = output_options_from(info[1].As<Object>());
+  pl::list_t tasks;
+  pl::scan_stats stats;
+
+  if (output.stats) {
+    options.stats = &stats;
+  }
+
+  try {
+    pl::probe measure(options.stats, pl::PHASE_SCAN);
+    tasks = pl::list(fields, options);
+  } catch(const std::exception &e) {
+    return Nan::ThrowError(e.what());
+  }
+
+  if (options.stats) {
+    pl::record(stats);
+  }
+
+  Local<Value> result;
+
+  {
+    pl::probe measure(options.stats, pl::PHASE_CONVERT);
+
+    if (!output.columnar) {
+      result = to_array(tasks, fields, output);
+    } else {
+      auto columns = pl::to_columns(tasks, fields, PL_HAS_BIGINT);
+      result = to_columns(&columns, fields);
+    }
+  }
+
+  if (options.stats) {
+    attach_stats(result, stats);
+  }
+
+  info.GetReturnValue().Set(result);
+}
+
+NAN_METHOD(getStats) {
+  pl::cumulative_stats cumulative = pl::cumulative();
+  Local<Object> result = to_stats(cumulative.totals);
+  Local<Object> histograms = Nan::New<Object>();
+
+  for (size_t i = 0; i < pl::PHASE_COUNT; ++i) {
+    Local<Array> histogram = Nan::New<Array>(pl::HISTOGRAM_SIZE);
+
+    for (size_t j = 0; j < pl::HISTOGRAM_SIZE; ++j) {
+      Nan::Set(histogram, j, Nan::New<Number>(cumulative.histograms[i][j]));
+    }
+
+    Nan::Set(histograms, STR(pl::phase_names[i]), histogram);
+  }
+
+  pl::metadata_counters counters = pl::metadata_cache::shared().counters();
+  Local<Object> cache = Nan::New<Object>();
+
+  Nan::Set(cache, STR("size"), Nan::New<Number>(counters.size));
+  Nan::Set(cache, STR("hits"), Nan::New<Number>(counters.hits));
+  Nan::Set(cache, STR("misses"), Nan::New<Number>(counters.misses));
+  Nan::Set(cache, STR("invalidations"),
+    Nan::New<Number>(counters.invalidations));
+  Nan::Set(cache, STR("evictions"), Nan::New<Number>(counters.evictions));
+
+  Nan::Set(result, STR("snapshots"), Nan::New<Number>(cumulative.snapshots));
+  Nan::Set(result, STR("histograms"), histograms);
+  Nan::Set(result, STR("metadataCache"), cache);
 
-  Nan::AsyncQueueWorker(new SnapshotWorker(callback, fields));
+  info.GetReturnValue().Set(result);
 }
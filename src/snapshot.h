@@ -9,6 +9,142 @@
 
 #include <nan.h>
 
+#include "tasklist.h"  // NOLINT(build/include)
+#include "columns.h"  // NOLINT(build/include)
+#include "stats.h"  // NOLINT(build/include)
+
+/**
+ * `BigUint64Array` is available since V8 6.7
+ */
+#if V8_MAJOR_VERSION > 6 || (V8_MAJOR_VERSION == 6 && V8_MINOR_VERSION >= 7)
+#define PL_HAS_BIGINT 1
+#else
+#define PL_HAS_BIGINT 0
+#endif
+
+/**
+ * js type of 64-bit fields: vmem, pmem, utime, stime
+ */
+enum numeric_mode {
+  NUMERIC_STRING,
+  NUMERIC_NUMBER,  // `BigInt` when the value exceeds 2^53
+  NUMERIC_BIGINT
+};
+
+/**
+ * shape of the result passed to js
+ */
+struct output_options {
+  // object of typed arrays instead of array of objects
+  bool columnar = false;
+  numeric_mode numeric = NUMERIC_STRING;
+  // attach per-phase stats of the scan to the result
+  bool stats = false;
+  // create objects from templates, without them properties are added
+  // one by one, it's the baseline of `bench/convert.js`
+  bool templates = true;
+};
+
+/**
+ * read process list on the thread pool and pass it to the callback
+ */
+class SnapshotWorker : public Nan::AsyncWorker {
+ public:
+  SnapshotWorker(Nan::Callback *callback,
+                 const struct pl::process_fields &fields,
+                 const struct pl::list_options &options,
+                 const struct output_options &output);
+
+  ~SnapshotWorker() {}
+
+  void Execute();
+  void HandleOKCallback();
+  void HandleErrorCallback();
+
+ protected:
+  /**
+   * read process list, it's called on the thread pool
+   */
+  virtual pl::list_t Collect();
+
+  pl::list_t tasks;
+  pl::columns columns;
+  pl::process_fields psfields;
+  pl::list_options psoptions;
+  output_options psoutput;
+  pl::scan_stats stats;
+};
+
+/**
+ * create property names shared by all snapshots, call it at module init
+ */
+void init_keys();
+
+/**
+ * convert 64-bit value according to the numeric mode
+ */
+v8::Local<v8::Value> wide(uint64_t value, numeric_mode mode);
+
+/**
+ * convert process list to js array of objects with requested fields
+ */
+v8::Local<v8::Array> to_array(const pl::list_t &tasks,
+                              const struct pl::process_fields &fields,
+                              const struct output_options &output);
+
+v8::Local<v8::Array> to_array(const pl::process *tasks, size_t count,
+                              const struct pl::process_fields &fields,
+                              const struct output_options &output);
+
+/**
+ * convert columns to js object of typed arrays,
+ * memory of columns is handed over to js
+ */
+v8::Local<v8::Object> to_columns(pl::columns *columns,
+                                 const struct pl::process_fields &fields);
+
+/**
+ * convert stats of the scan to js object, times are in ns
+ */
+v8::Local<v8::Object> to_stats(const pl::scan_stats &stats);
+
+/**
+ * record the conversion and attach stats to the result as a non-enumerable
+ * property, so it doesn't show up in comparisons and serialization
+ */
+void attach_stats(v8::Local<v8::Value> result, const pl::scan_stats &stats);
+
+/**
+ * read requested fields from js object
+ */
+struct pl::process_fields process_fields_from(v8::Local<v8::Object> obj);
+
+/**
+ * read list options from js object
+ */
+struct pl::list_options list_options_from(v8::Local<v8::Object> obj);
+
+/**
+ * read output options from js object
+ */
+struct output_options output_options_from(v8::Local<v8::Object> obj);
+
+/**
+ * queue the worker to the thread pool,
+ * or to the dedicated thread with `executor: 'dedicated'` option
+ */
+void queue_worker(Nan::AsyncWorker *worker, v8::Local<v8::Object> obj);
+
 NAN_METHOD(snapshot);
 
+/**
+ * read process list on the calling thread
+ */
+NAN_METHOD(snapshotSync);
+
+/**
+ * cumulative stats of all snapshots with `stats` option
+ */
+NAN_METHOD(getStats);
+
 #endif  // SRC_SNAPSHOT_H_
@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "stats.h"  // NOLINT(build/include)
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <mutex>  // NOLINT(build/c++11)
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+static std::mutex cumulative_lock;
+static pl::cumulative_stats totals;
+
+/**
+ * phases measured once per snapshot, the thread cpu time
+ * costs a syscall, so it isn't read for every process
+ */
+static inline bool whole_snapshot(pl::scan_phase phase) {
+  return phase == pl::PHASE_LIST || phase == pl::PHASE_SCAN ||
+    phase == pl::PHASE_CONVERT;
+}
+
+/**
+ * histogram bucket of the wall time
+ */
+static size_t bucket(uint64_t ns) {
+  uint64_t us = ns / 1000;
+  size_t index = 0;
+
+  while (us != 0 && index < pl::HISTOGRAM_SIZE - 1) {
+    us >>= 1;
+    ++index;
+  }
+
+  return index;
+}
+
+namespace pl {
+
+const char *const phase_names[PHASE_COUNT] = {
+  "list",
+  "stat",
+  "cmdline",
+  "owner",
+  "path",
+  "mem",
+  "rollup",
+  "io",
+  "tasks",
+  "cache",
+  "scan",
+  "convert"
+};
+
+thread_local io_counters thread_io = { 0, 0 };
+
+void phase_stats::merge(const phase_stats &other) {
+  calls += other.calls;
+  wall += other.wall;
+  cpu += other.cpu;
+  syscalls += other.syscalls;
+  bytes += other.bytes;
+}
+
+void scan_stats::merge(const scan_stats &other) {
+  for (size_t i = 0; i < PHASE_COUNT; ++i) {
+    phases[i].merge(other.phases[i]);
+  }
+
+  processes += other.processes;
+  skipped += other.skipped;
+  vanished += other.vanished;
+}
+
+uint64_t thread_cputime() {
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+
+  if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+    return 0;
+  }
+
+  ULARGE_INTEGER k, u;
+  k.LowPart = kernel.dwLowDateTime;
+  k.HighPart = kernel.dwHighDateTime;
+  u.LowPart = user.dwLowDateTime;
+  u.HighPart = user.dwHighDateTime;
+
+  // 100 ns intervals
+  return (k.QuadPart + u.QuadPart) * 100;
+#else
+  struct timespec ts;
+
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+probe::probe(scan_stats *stats, scan_phase phase)
+: stats(stats), phase(phase), thread_time(stats && whole_snapshot(phase)),
+  cpu(0), io(thread_io) {
+  if (stats) {
+    wall = steady_clock::now();
+    cpu = thread_time ? thread_cputime() : 0;
+  }
+}
+
+probe::~probe() {
+  if (!stats) {
+    return;
+  }
+
+  phase_stats &current = stats->phases[phase];
+
+  current.calls += 1;
+  current.wall += duration_cast<nanoseconds>(
+    steady_clock::now() - wall).count();
+  current.cpu += thread_time ? thread_cputime() - cpu : 0;
+  current.syscalls += thread_io.syscalls - io.syscalls;
+  current.bytes += thread_io.bytes - io.bytes;
+}
+
+void record(const scan_stats &stats) {
+  std::lock_guard<std::mutex> guard(cumulative_lock);
+
+  totals.snapshots += 1;
+  totals.totals.merge(stats);
+
+  for (size_t i = 0; i < PHASE_COUNT; ++i) {
+    if (stats.phases[i].calls != 0) {
+      totals.histograms[i][bucket(stats.phases[i].wall)] += 1;
+    }
+  }
+}
+
+void record(scan_phase phase, const phase_stats &stats) {
+  std::lock_guard<std::mutex> guard(cumulative_lock);
+
+  totals.totals.phases[phase].merge(stats);
+  totals.histograms[phase][bucket(stats.wall)] += 1;
+}
+
+cumulative_stats cumulative() {
+  std::lock_guard<std::mutex> guard(cumulative_lock);
+  return totals;
+}
+
+}  // namespace pl
@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_STATS_H_
+#define SRC_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>  // NOLINT(build/c++11)
+
+namespace pl {
+
+/**
+ * measured parts of the snapshot
+ */
+enum scan_phase {
+  PHASE_LIST,  // reading of `/proc`
+  PHASE_STAT,
+  PHASE_CMDLINE,
+  PHASE_OWNER,  // uid and user name
+  PHASE_PATH,
+  PHASE_MEM,
+  PHASE_ROLLUP,
+  PHASE_IO,
+  PHASE_TASKS,
+  PHASE_CACHE,  // exec check and copy of cached metadata
+  PHASE_SCAN,  // the whole scan on the worker thread
+  PHASE_CONVERT,  // conversion to js on the main thread
+  PHASE_COUNT
+};
+
+/**
+ * js names of phases
+ */
+extern const char *const phase_names[PHASE_COUNT];
+
+struct phase_stats {
+  uint64_t calls = 0;
+
+  // ns of wall time and of cpu time of the thread,
+  // cpu time is measured only by phases of the whole snapshot
+  uint64_t wall = 0;
+  uint64_t cpu = 0;
+
+  uint64_t syscalls = 0;
+  uint64_t bytes = 0;
+
+  void merge(const phase_stats &other);
+};
+
+struct scan_stats {
+  phase_stats phases[PHASE_COUNT];
+
+  // read, filtered out and exited during the scan processes
+  uint64_t processes = 0;
+  uint64_t skipped = 0;
+  uint64_t vanished = 0;
+
+  void merge(const scan_stats &other);
+};
+
+/**
+ * syscalls made and bytes read from procfs by the current thread,
+ * they are counted by the readers
+ */
+struct io_counters {
+  uint64_t syscalls;
+  uint64_t bytes;
+};
+
+extern thread_local io_counters thread_io;
+
+/**
+ * cpu time of the current thread in ns
+ */
+uint64_t thread_cputime();
+
+/**
+ * adds the time and io of its scope to the phase, does nothing without stats.
+ * Per-process phases read only the monotonic clock, which doesn't need
+ * a syscall, so a measured scan isn't much slower than the plain one
+ */
+class probe {
+ public:
+  probe(scan_stats *stats, scan_phase phase);
+  ~probe();
+
+  probe(const probe &) = delete;
+  probe &operator=(const probe &) = delete;
+
+ private:
+  scan_stats *stats;
+  scan_phase phase;
+  std::chrono::steady_clock::time_point wall;
+  bool thread_time;
+  uint64_t cpu;
+  io_counters io;
+};
+
+/**
+ * number of buckets of histograms, bucket `i` counts phases
+ * of `[2^(i-1), 2^i)` microseconds, the last one is open
+ */
+const size_t HISTOGRAM_SIZE = 32;
+
+/**
+ * totals of all snapshots with stats since the start
+ */
+struct cumulative_stats {
+  uint64_t snapshots = 0;
+  scan_stats totals;
+  uint64_t histograms[PHASE_COUNT][HISTOGRAM_SIZE] = {};
+};
+
+/**
+ * add stats of the snapshot to cumulative ones
+ */
+void record(const scan_stats &stats);
+
+/**
+ * add the phase measured apart from the scan, e.g. the conversion
+ */
+void record(scan_phase phase, const phase_stats &stats);
+
+cumulative_stats cumulative();
+
+}  // namespace pl
+
+#endif  // SRC_STATS_H_
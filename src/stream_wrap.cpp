@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "stream_wrap.h"  // NOLINT(build/include)
+
+#include <nan.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <stdexcept>
+#include <string>
+
+#include "snapshot.h"  // NOLINT(build/include)
+
+using v8::FunctionTemplate;
+using v8::Function;
+using v8::Object;
+using v8::Local;
+using v8::Value;
+using pl::process_fields;
+using pl::list_options;
+
+#define STR(s) Nan::New<v8::String>(s).ToLocalChecked()
+
+/**
+ * max number of batches sent to js and not consumed yet
+ */
+static const uint32_t MAX_PENDING = 2;
+
+class StreamWorker : public Nan::AsyncProgressQueueWorker<pl::process> {
+ public:
+  StreamWorker(Nan::Callback *callback,
+               Nan::Callback *progress,
+               const struct process_fields &fields,
+               const struct list_options &options,
+               const struct output_options &output,
+               size_t batch_size,
+               uint32_t idle_timeout,
+               Stream *stream)
+  : Nan::AsyncProgressQueueWorker<pl::process>(callback),
+    progress(progress), psfields(fields), psoptions(options),
+    psoutput(output), batch_size(batch_size), idle_timeout(idle_timeout),
+    stream(stream) {
+  }
+
+  ~StreamWorker() {
+    delete progress;
+  }
+
+  void Execute(const ExecutionProgress &sender) {
+    try {
+      pl::list(psfields, psoptions, batch_size,
+        [this, &sender](pl::list_t *batch) {
+          if (!stream->Acquire(idle_timeout)) {
+            return false;
+          }
+
+          sender.Send(batch->data(), batch->size());
+          return true;
+        });
+    } catch(const std::exception &e) {
+      SetErrorMessage(e.what());
+    }
+  }
+
+  void HandleProgressCallback(const pl::process *tasks, size_t count) {
+    Nan::HandleScope scope;
+
+    Local<Value> argv[] = {
+      to_array(tasks, count, psfields, psoutput)
+    };
+
+    progress->Call(1, argv, async_resource);
+  }
+
+ private:
+  Nan::Callback *progress;
+  pl::process_fields psfields;
+  pl::list_options psoptions;
+  output_options psoutput;
+  size_t batch_size;
+  uint32_t idle_timeout;
+  Stream *stream;
+};
+
+bool Stream::Acquire(uint32_t timeout) {
+  std::unique_lock<std::mutex> guard(lock);
+
+  bool ready = consumed.wait_for(guard, std::chrono::milliseconds(timeout),
+    [this]() {
+      return cancelled || pending < MAX_PENDING;
+    });
+
+  if (!ready) {
+    cancelled = true;
+    throw std::runtime_error("batches aren't consumed for " +
+      std::to_string(timeout) + " ms");
+  }
+
+  if (cancelled) {
+    return false;
+  }
+
+  ++pending;
+  return true;
+}
+
+NAN_MODULE_INIT(Stream::Init) {
+  Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+  tpl->SetClassName(Nan::New("Stream").ToLocalChecked());
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::SetPrototypeMethod(tpl, "read", Read);
+  Nan::SetPrototypeMethod(tpl, "ack", Ack);
+  Nan::SetPrototypeMethod(tpl, "cancel", Cancel);
+
+  Nan::Set(target, Nan::New("Stream").ToLocalChecked(),
+    Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+NAN_METHOD(Stream::New) {
+  if (!info.IsConstructCall()) {
+    return Nan::ThrowTypeError("Class constructor Stream cannot be invoked "
+      "without 'new'");
+  }
+
+  Stream *obj = new Stream();
+  obj->Wrap(info.This());
+
+  info.GetReturnValue().Set(info.This());
+}
+
+/**
+ * read(fields, options, onBatch, onEnd)
+ */
+NAN_METHOD(Stream::Read) {
+  Stream *obj = Nan::ObjectWrap::Unwrap<Stream>(info.Holder());
+
+  auto fields = process_fields_from(info[0].As<Object>());
+  auto options = list_options_from(info[1].As<Object>());
+  auto output = output_options_from(info[1].As<Object>());
+  auto *progress = new Nan::Callback(info[2].As<Function>());
+  auto *callback = new Nan::Callback(info[3].As<Function>());
+
+  uint32_t batch_size = Nan::To<uint32_t>(
+    Nan::Get(info[1].As<Object>(), STR("batchSize")).ToLocalChecked())
+    .FromJust();
+  uint32_t idle_timeout = Nan::To<uint32_t>(
+    Nan::Get(info[1].As<Object>(), STR("idleTimeout")).ToLocalChecked())
+    .FromJust();
+
+  // batches are arrays of objects
+  output.columnar = false;
+
+  auto *worker = new StreamWorker(callback, progress, fields, options, output,
+    std::max(1u, batch_size), idle_timeout, obj);
+
+  // keep the stream alive until the worker is done
+  worker->SaveToPersistent("stream", info.Holder());
+
+  queue_worker(worker, info[1].As<Object>());
+}
+
+/**
+ * js has consumed the batch
+ */
+NAN_METHOD(Stream::Ack) {
+  Stream *obj = Nan::ObjectWrap::Unwrap<Stream>(info.Holder());
+
+  {
+    std::lock_guard<std::mutex> guard(obj->lock);
+
+    if (obj->pending > 0) {
+      --obj->pending;
+    }
+  }
+
+  obj->consumed.notify_one();
+}
+
+/**
+ * stop reading, unread processes are skipped
+ */
+NAN_METHOD(Stream::Cancel) {
+  Stream *obj = Nan::ObjectWrap::Unwrap<Stream>(info.Holder());
+
+  {
+    std::lock_guard<std::mutex> guard(obj->lock);
+    obj->cancelled = true;
+  }
+
+  obj->consumed.notify_one();
+}
@@ -0,0 +1,49 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_STREAM_WRAP_H_
+#define SRC_STREAM_WRAP_H_
+
+#include <nan.h>
+
+#include <stdint.h>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <mutex>  // NOLINT(build/c++11)
+
+/**
+ * reads process list in batches passed to js as soon as they are read,
+ * the reader waits while js has too many unconsumed batches
+ */
+class Stream : public Nan::ObjectWrap {
+ public:
+  static NAN_MODULE_INIT(Init);
+
+  /**
+   * wait for a free slot of the batch, it's called on the reader thread,
+   * return false when the stream is cancelled. Throws when js doesn't
+   * consume batches for `timeout` ms, so an abandoned stream
+   * doesn't keep the thread forever
+   */
+  bool Acquire(uint32_t timeout);
+
+ private:
+  Stream() : pending(0), cancelled(false) {}
+  ~Stream() {}
+
+  static NAN_METHOD(New);
+  static NAN_METHOD(Read);
+  static NAN_METHOD(Ack);
+  static NAN_METHOD(Cancel);
+
+  std::mutex lock;
+  std::condition_variable consumed;
+
+  // sent, but not consumed batches
+  uint32_t pending;
+  bool cancelled;
+};
+
+#endif  // SRC_STREAM_WRAP_H_
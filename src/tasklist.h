@@ -11,20 +11,39 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <functional>
+
+#include "arena.h"  // NOLINT(build/include)
+#include "stats.h"  // NOLINT(build/include)
 
 #define NORMAL(x, low, high) (((x) > (high))?(high):(((x) < (low))?(low):(x)))
 
 namespace pl {
 
+/**
+ * thread of the process, times are in ms
+ */
+struct thread_info {
+  uint32_t tid = 0;
+  std::string name;
+  char state = 0;
+
+  uint64_t starttime = 0;
+  double cpu = 0;
+  uint64_t utime = 0;
+  uint64_t stime = 0;
+};
+
 struct process {
   uint32_t pid = 0;
   uint32_t ppid = 0;
 
-  std::string path;
-  std::string name;
-  std::string cmdline;
+  string_ref path;
+  string_ref name;
+  string_ref cmdline;
 
-  std::string owner;
+  string_ref owner;
+  uint32_t uid = 0;
 
   uint32_t threads = 0;
   int32_t priority = 0;
@@ -36,6 +55,27 @@ struct process {
   double cpu = 0;
   uint64_t utime = 0;
   uint64_t stime = 0;
+
+  // bytes, proportional and unique set size
+  uint64_t pss = 0;
+  uint64_t uss = 0;
+  uint64_t swap = 0;
+  uint64_t shared = 0;
+
+  // bytes fetched from and sent to the storage layer
+  uint64_t read_bytes = 0;
+  uint64_t write_bytes = 0;
+
+  // bytes and number of read and write syscalls
+  uint64_t rchar = 0;
+  uint64_t wchar = 0;
+  uint64_t syscr = 0;
+  uint64_t syscw = 0;
+
+  std::vector<thread_info> tasks;
+
+  // arena of the strings above, shared by processes read together
+  std::shared_ptr<const string_arena> strings;
 };
 
 struct process_fields {
@@ -45,6 +85,7 @@ struct process_fields {
   bool path;
   bool name;
   bool owner;
+  bool uid;
   bool cmdline;
 
   bool threads;
@@ -57,11 +98,125 @@ struct process_fields {
   bool cpu;
   bool utime;
   bool stime;
+
+  bool pss;
+  bool uss;
+  bool swap;
+  bool shared;
+
+  bool read_bytes;
+  bool write_bytes;
+  bool rchar;
+  bool wchar;
+  bool syscr;
+  bool syscw;
+
+  // per-thread details
+  bool tasks;
+};
+
+/**
+ * processes to read, other ones are skipped as early as possible
+ */
+struct process_filter {
+  // sorted list of pids, empty means any
+  std::vector<uint32_t> pids;
+
+  bool has_ppid = false;
+  uint32_t ppid = 0;
+
+  bool has_uid = false;
+  uint32_t uid = 0;
+
+  // owner name, empty means any
+  std::string owner;
+
+  // glob pattern of the process name, empty means any
+  std::string name;
+};
+
+struct list_options {
+  // number of threads used to read per-process data, 1 means sequential
+  uint32_t concurrency = 1;
+
+  // how long resolved owner names are cached, in ms, 0 disables the cache
+  uint32_t owner_ttl = 60000;
+
+  // skip processes which don't match
+  process_filter filter;
+
+  // max number of processes whose path and cmdline are kept between
+  // snapshots, 0 disables the cache
+  uint32_t cache_size = 0;
+
+  // root of procfs, another one is used by benchmarks with fixtures
+  std::string procfs = "/proc";
+
+  // phases of the scan are measured when it's set
+  scan_stats *stats = NULL;
 };
 
 typedef std::vector<process> list_t;
 
-list_t list(const struct process_fields &);
+/**
+ * identity of the process, pid alone may be reused
+ */
+struct process_key {
+  uint32_t pid;
+  uint64_t starttime;
+
+  explicit process_key(const process &proc)
+  : pid(proc.pid), starttime(proc.starttime) {
+  }
+
+  process_key(uint32_t pid, uint64_t starttime)
+  : pid(pid), starttime(starttime) {
+  }
+
+  bool operator==(const process_key &other) const {
+    return pid == other.pid && starttime == other.starttime;
+  }
+};
+
+struct process_key_hash {
+  size_t operator()(const process_key &key) const {
+    return std::hash<uint64_t>()(key.starttime ^ (uint64_t(key.pid) << 32));
+  }
+};
+
+/**
+ * receives the next batch of processes, return false to stop reading
+ */
+typedef std::function<bool(list_t *batch)> batch_handler;
+
+list_t list(const struct process_fields &, const struct list_options &);
+
+/**
+ * read processes in batches of up to `batch_size` in the order of `list`,
+ * so only one batch is kept in memory
+ */
+void list(const struct process_fields &, const struct list_options &,
+          size_t batch_size, const batch_handler &);
+
+/**
+ * copy strings of the process to an arena of its own, so the process kept
+ * between snapshots doesn't hold the arena of the whole snapshot
+ */
+inline void own_strings(process *proc) {
+  if (!proc->strings) {
+    return;
+  }
+
+  auto strings = std::make_shared<string_arena>();
+  strings->reserve(proc->path.size + proc->name.size + proc->cmdline.size +
+    proc->owner.size + 4);
+
+  proc->path = strings->store(proc->path.data, proc->path.size);
+  proc->name = strings->store(proc->name.data, proc->name.size);
+  proc->cmdline = strings->store(proc->cmdline.data, proc->cmdline.size);
+  proc->owner = strings->store(proc->owner.data, proc->owner.size);
+  proc->strings = strings;
+}
 
 };  // namespace pl
 
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "tree.h"  // NOLINT(build/include)
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pl {
+
+static const size_t NO_PARENT = static_cast<size_t>(-1);
+
+tree_t tree(const list_t &list) {
+  size_t size = list.size();
+
+  std::unordered_map<uint32_t, size_t> index;
+  index.reserve(size);
+
+  for (size_t i = 0; i < size; ++i) {
+    index[list[i].pid] = i;
+  }
+
+  // children index: children of `i` are
+  // `children[offsets[i]]` .. `children[offsets[i + 1] - 1]`
+  std::vector<size_t> parents(size, NO_PARENT);
+  std::vector<size_t> offsets(size + 1, 0);
+
+  for (size_t i = 0; i < size; ++i) {
+    auto parent = index.find(list[i].ppid);
+
+    if (parent != index.end() && parent->second != i) {
+      parents[i] = parent->second;
+      ++offsets[parent->second + 1];
+    }
+  }
+
+  for (size_t i = 0; i < size; ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+
+  std::vector<size_t> children(offsets[size]);
+  std::vector<size_t> filled(offsets.begin(), offsets.end() - 1);
+
+  for (size_t i = 0; i < size; ++i) {
+    if (parents[i] != NO_PARENT) {
+      children[filled[parents[i]]++] = i;
+    }
+  }
+
+  // pre-order walk, `parent` of the node is its position in `nodes`
+  tree_t nodes;
+  nodes.reserve(size);
+
+  std::vector<size_t> tree_parents;
+  tree_parents.reserve(size);
+
+  std::vector<bool> visited(size, false);
+  std::vector<std::pair<size_t, size_t>> stack;
+
+  auto walk = [&nodes, &tree_parents, &visited, &stack, &offsets, &children,
+               &list](size_t root) {
+    stack.emplace_back(root, NO_PARENT);
+
+    while (!stack.empty()) {
+      size_t i = stack.back().first;
+      size_t parent = stack.back().second;
+      stack.pop_back();
+
+      // pids reused by a descendant may make a cycle
+      if (visited[i]) {
+        continue;
+      }
+
+      visited[i] = true;
+
+      tree_node node;
+      node.index = i;
+      node.depth = parent == NO_PARENT ? 0 : nodes[parent].depth + 1;
+      node.subtree.count = 1;
+      node.subtree.threads = list[i].threads;
+      node.subtree.vmem = list[i].vmem;
+      node.subtree.pmem = list[i].pmem;
+      node.subtree.cpu = list[i].cpu;
+
+      nodes.push_back(node);
+      tree_parents.push_back(parent);
+
+      // push in reverse, so children are visited in the list order
+      for (size_t c = offsets[i + 1]; c > offsets[i]; --c) {
+        stack.emplace_back(children[c - 1], nodes.size() - 1);
+      }
+    }
+  };
+
+  for (size_t i = 0; i < size; ++i) {
+    if (parents[i] == NO_PARENT) {
+      walk(i);
+    }
+  }
+
+  // processes of cycles aren't reachable from roots
+  for (size_t i = 0; i < size; ++i) {
+    if (!visited[i]) {
+      walk(i);
+    }
+  }
+
+  // post-order pass: every child is after its parent in pre-order
+  for (size_t n = nodes.size(); n-- > 0;) {
+    size_t parent = tree_parents[n];
+
+    if (parent == NO_PARENT) {
+      continue;
+    }
+
+    subtree_t &total = nodes[parent].subtree;
+    const subtree_t &sub = nodes[n].subtree;
+
+    total.count += sub.count;
+    total.threads += sub.threads;
+    total.vmem += sub.vmem;
+    total.pmem += sub.pmem;
+    total.cpu += sub.cpu;
+  }
+
+  return nodes;
+}
+
+}  // namespace pl
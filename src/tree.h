@@ -0,0 +1,50 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_TREE_H_
+#define SRC_TREE_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "tasklist.h"  // NOLINT(build/include)
+
+namespace pl {
+
+/**
+ * totals of the process and all its descendants
+ */
+struct subtree_t {
+  uint32_t count = 0;
+  uint32_t threads = 0;
+  uint64_t vmem = 0;
+  uint64_t pmem = 0;
+  double cpu = 0;
+};
+
+struct tree_node {
+  // index of the process in the source list
+  size_t index;
+
+  // 0 for roots
+  uint32_t depth;
+
+  subtree_t subtree;
+};
+
+typedef std::vector<tree_node> tree_t;
+
+/**
+ * build process tree from `pid` and `ppid`,
+ * nodes are returned in depth-first pre-order,
+ * children are in the order of the source list.
+ * Processes with unknown parent are roots.
+ */
+tree_t tree(const list_t &list);
+
+}  // namespace pl
+
+#endif  // SRC_TREE_H_
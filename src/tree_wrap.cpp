@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "tree_wrap.h"  // NOLINT(build/include)
+
+#include <nan.h>
+
+#include <utility>
+#include <vector>
+
+#include "snapshot.h"  // NOLINT(build/include)
+#include "tree.h"  // NOLINT(build/include)
+
+using v8::Function;
+using v8::Object;
+using v8::Array;
+using v8::Number;
+using v8::String;
+using v8::Local;
+using v8::Value;
+using pl::process_fields;
+using pl::list_options;
+
+#define STR(s) Nan::New<v8::String>(s).ToLocalChecked()
+
+class TreeWorker : public SnapshotWorker {
+ public:
+  TreeWorker(Nan::Callback *callback,
+             const struct process_fields &fields,
+             const struct list_options &options,
+             const struct output_options &output,
+             bool roots)
+  : SnapshotWorker(callback, fields, options, output), roots(roots) {
+    // the tree is linked by pid and ppid, totals need the summed fields
+    psfields.pid = psfields.ppid = true;
+    psfields.threads = psfields.vmem = psfields.pmem = psfields.cpu = true;
+  }
+
+  void Execute() {
+    try {
+      {
+        pl::probe measure(psoptions.stats, pl::PHASE_SCAN);
+        Build();
+      }
+
+      if (psoptions.stats) {
+        pl::record(stats);
+      }
+    } catch(const std::exception &e) {
+      SetErrorMessage(e.what());
+    }
+  }
+
+  void HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    Local<Array> result;
+
+    {
+      pl::probe measure(psoptions.stats, pl::PHASE_CONVERT);
+      result = Convert();
+    }
+
+    if (psoptions.stats) {
+      attach_stats(result, stats);
+    }
+
+    Local<Value> argv[] = {
+      Nan::Null(),
+      result
+    };
+
+    callback->Call(2, argv, async_resource);
+  }
+
+ private:
+  /**
+   * read the list and order it like the tree, it's called on the thread pool
+   */
+  void Build() {
+    pl::list_t list = Collect();
+    pl::tree_t nodes = pl::tree(list);
+
+    // order processes like the nodes, so they are converted as is
+    for (const pl::tree_node &node : nodes) {
+      if (roots && node.depth > 0) {
+        continue;
+      }
+
+      tasks.push_back(std::move(list[node.index]));
+      tree.push_back(node);
+    }
+  }
+
+  /**
+   * convert processes with depth and totals of their subtrees
+   */
+  Local<Array> Convert() {
+    Local<Array> result = to_array(tasks, psfields, psoutput);
+
+    Local<String> depth = STR("depth");
+    Local<String> subtree = STR("subtree");
+    Local<String> count = STR("count");
+    Local<String> threads = STR("threads");
+    Local<String> vmem = STR("vmem");
+    Local<String> pmem = STR("pmem");
+    Local<String> cpu = STR("cpu");
+
+    for (uint32_t i = 0; i < tree.size(); ++i) {
+      const pl::subtree_t &totals = tree[i].subtree;
+      Local<Object> task = Nan::Get(result, i).ToLocalChecked().As<Object>();
+      Local<Object> sub = Nan::New<Object>();
+
+      Nan::Set(sub, count, Nan::New<Number>(totals.count));
+      Nan::Set(sub, threads, Nan::New<Number>(totals.threads));
+      Nan::Set(sub, vmem, wide(totals.vmem, psoutput.numeric));
+      Nan::Set(sub, pmem, wide(totals.pmem, psoutput.numeric));
+      Nan::Set(sub, cpu, Nan::New<Number>(totals.cpu));
+
+      Nan::Set(task, depth, Nan::New<Number>(tree[i].depth));
+      Nan::Set(task, subtree, sub);
+    }
+
+    return result;
+  }
+
+  // only roots with totals of the whole tree
+  bool roots;
+  pl::tree_t tree;
+};
+
+NAN_METHOD(tree) {
+  auto fields = process_fields_from(info[0].As<Object>());
+  auto options = list_options_from(info[1].As<Object>());
+  auto output = output_options_from(info[1].As<Object>());
+  auto *callback = new Nan::Callback(info[2].As<Function>());
+  bool roots = Nan::To<bool>(
+    Nan::Get(info[1].As<Object>(), STR("roots")).ToLocalChecked()).FromJust();
+
+  // depth and totals are attached to process objects
+  output.columnar = false;
+
+  queue_worker(new TreeWorker(callback, fields, options, output, roots),
+    info[1].As<Object>());
+}
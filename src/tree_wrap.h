@@ -0,0 +1,17 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_TREE_WRAP_H_
+#define SRC_TREE_WRAP_H_
+
+#include <nan.h>
+
+/**
+ * get process tree with subtree totals
+ */
+NAN_METHOD(tree);
+
+#endif  // SRC_TREE_WRAP_H_
@@ -0,0 +1,389 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "unix/procstat.h"  // NOLINT(build/include)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "stats.h"  // NOLINT(build/include)
+
+namespace {
+
+/**
+ * `/proc/$pid/stat` is ~300 bytes, `comm` is the only field
+ * of variable length and it's limited by `COMM_SIZE`
+ */
+const size_t STAT_SIZE = 1024;
+
+/**
+ * `smaps_rollup` is ~1 KB, `status` is ~1.5 KB
+ */
+const size_t ROLLUP_SIZE = 4096;
+
+/**
+ * `/proc/$pid/io` is ~200 bytes
+ */
+const size_t IO_SIZE = 512;
+
+/**
+ * check the key of `Key: value` line
+ */
+inline bool is_key(const char *line, size_t size, const char *key) {
+  size_t len = strlen(key);
+  return size == len && !memcmp(line, key, len);
+}
+
+/**
+ * read the whole file, seq files may be returned in several chunks.
+ * Return the size or -1 when the file can't be opened
+ */
+ssize_t read_file(int dirfd, const char *path, char *buf, size_t bufsize) {
+  int fd = openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+  ++pl::thread_io.syscalls;
+
+  if (fd == -1) {
+    return -1;
+  }
+
+  size_t size = 0;
+  int error = 0;
+
+  while (size < bufsize) {
+    ssize_t n = read(fd, buf + size, bufsize - size);
+    ++pl::thread_io.syscalls;
+
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+
+    if (n == -1) {
+      error = errno;
+    }
+
+    if (n <= 0) {
+      break;
+    }
+
+    size += n;
+  }
+
+  close(fd);
+  ++pl::thread_io.syscalls;
+  pl::thread_io.bytes += size;
+
+  // e.g. ESRCH of the process exited after `open`
+  if (size == 0 && error != 0) {
+    errno = error;
+    return -1;
+  }
+
+  return size;
+}
+
+/**
+ * cursor over the numeric part of `/proc/$pid/stat`
+ */
+struct reader {
+  const char *pos;
+  const char *end;
+
+  bool skip() {
+    while (pos < end && *pos == ' ') {
+      ++pos;
+    }
+
+    if (pos == end) {
+      return false;
+    }
+
+    while (pos < end && *pos != ' ' && *pos != '\n') {
+      ++pos;
+    }
+
+    return true;
+  }
+
+  bool next(uint64_t *value) {
+    while (pos < end && *pos == ' ') {
+      ++pos;
+    }
+
+    if (pos == end || *pos < '0' || *pos > '9') {
+      return false;
+    }
+
+    uint64_t v = 0;
+
+    while (pos < end && *pos >= '0' && *pos <= '9') {
+      v = v * 10 + (*pos - '0');
+      ++pos;
+    }
+
+    *value = v;
+    return true;
+  }
+
+  bool next(int64_t *value) {
+    while (pos < end && *pos == ' ') {
+      ++pos;
+    }
+
+    bool negative = pos < end && *pos == '-';
+
+    if (negative) {
+      ++pos;
+    }
+
+    uint64_t v;
+
+    if (!next(&v)) {
+      return false;
+    }
+
+    *value = negative ? -static_cast<int64_t>(v) : static_cast<int64_t>(v);
+    return true;
+  }
+};
+
+/**
+ * call `handler(key, key_size, value)` for every `Key: value` line
+ */
+template<class Handler>
+void each_value(const char *data, size_t size, Handler handler) {
+  const char *end = data + size;
+  const char *line = data;
+
+  while (line < end) {
+    const char *eol = static_cast<const char *>(
+      memchr(line, '\n', end - line));
+
+    if (eol == NULL) {
+      eol = end;
+    }
+
+    const char *colon = static_cast<const char *>(
+      memchr(line, ':', eol - line));
+
+    if (colon != NULL) {
+      reader r = { colon + 1, eol };
+      uint64_t value = 0;
+
+      // `status` separates values with tabs
+      while (r.pos < eol && (*r.pos == ' ' || *r.pos == '\t')) {
+        ++r.pos;
+      }
+
+      r.next(&value);
+      handler(line, colon - line, value);
+    }
+
+    line = eol + 1;
+  }
+}
+
+}  // namespace
+
+namespace pl {
+
+bool parse_procstat(const char *data, size_t size, procstat_t *pstat) {
+  const char *end = data + size;
+
+  // `comm` may contain spaces and parentheses,
+  // so it ends at the last `)` of the line
+  const char *open = static_cast<const char *>(memchr(data, '(', size));
+  const char *close = NULL;
+
+  for (const char *p = end; p > data; --p) {
+    if (p[-1] == ')') {
+      close = p - 1;
+      break;
+    }
+  }
+
+  if (open == NULL || close == NULL || close < open) {
+    return false;
+  }
+
+  reader r = { data, open };
+  uint64_t u;
+  int64_t i;
+
+  if (!r.next(&u)) {  // (1) pid
+    return false;
+  }
+
+  pstat->pid = static_cast<uint32_t>(u);
+
+  size_t comm_size = std::min<size_t>(close - open - 1, COMM_SIZE - 1);
+  memcpy(pstat->comm, open + 1, comm_size);
+  pstat->comm[comm_size] = '\0';
+
+  r.pos = close + 1;
+  r.end = end;
+
+  while (r.pos < end && *r.pos == ' ') {
+    ++r.pos;
+  }
+
+  if (r.pos == end) {
+    return false;
+  }
+
+  pstat->state = *r.pos++;  // (3)
+
+  if (!r.next(&u)) {  // (4) ppid
+    return false;
+  }
+
+  pstat->ppid = static_cast<uint32_t>(u);
+
+  for (int field = 5; field < 14; ++field) {
+    if (!r.skip()) {
+      return false;
+    }
+  }
+
+  if (!r.next(&pstat->utime) || !r.next(&pstat->stime)) {  // (14), (15)
+    return false;
+  }
+
+  if (!r.skip() || !r.skip()) {  // (16) cutime, (17) cstime
+    return false;
+  }
+
+  if (!r.next(&i)) {  // (18) priority
+    return false;
+  }
+
+  pstat->priority = static_cast<int32_t>(i);
+
+  if (!r.next(&i)) {  // (19) nice
+    return false;
+  }
+
+  pstat->nice = static_cast<int32_t>(i);
+
+  if (!r.next(&u)) {  // (20) num_threads
+    return false;
+  }
+
+  pstat->threads = static_cast<uint32_t>(u);
+
+  if (!r.skip()) {  // (21) itrealvalue
+    return false;
+  }
+
+  // (22) starttime, (23) vsize
+  if (!r.next(&pstat->uptime) || !r.next(&pstat->vsize)) {
+    return false;
+  }
+
+  if (!r.next(&i)) {  // (24) rss
+    return false;
+  }
+
+  pstat->rss = (i < 0) ? 0 : static_cast<uint64_t>(i);
+  return true;
+}
+
+bool read_procstat(int dirfd, const char *path, procstat_t *pstat) {
+  int fd = openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+  ++pl::thread_io.syscalls;
+
+  if (fd == -1) {
+    return false;
+  }
+
+  char buf[STAT_SIZE];
+  ssize_t size;
+
+  do {
+    size = read(fd, buf, sizeof(buf));
+    ++pl::thread_io.syscalls;
+  } while (size == -1 && errno == EINTR);
+
+  close(fd);
+  ++pl::thread_io.syscalls;
+  pl::thread_io.bytes += (size > 0) ? size : 0;
+
+  if (size <= 0) {
+    return false;
+  }
+
+  return parse_procstat(buf, size, pstat);
+}
+
+void parse_rollup(const char *data, size_t size, rollup_t *rollup) {
+  memset(rollup, 0, sizeof(*rollup));
+
+  each_value(data, size, [rollup](const char *key, size_t key_size,
+                                  uint64_t value) {
+    if (is_key(key, key_size, "Pss")) {
+      rollup->pss = value;
+    } else if (is_key(key, key_size, "Private_Clean") ||
+               is_key(key, key_size, "Private_Dirty")) {
+      rollup->uss += value;
+    } else if (is_key(key, key_size, "Shared_Clean") ||
+               is_key(key, key_size, "Shared_Dirty")) {
+      rollup->shared += value;
+    } else if (is_key(key, key_size, "Swap") ||
+               is_key(key, key_size, "VmSwap")) {
+      rollup->swap = value;
+    }
+  });
+}
+
+bool read_rollup(int dirfd, const char *path, rollup_t *rollup) {
+  char buf[ROLLUP_SIZE];
+  ssize_t size = read_file(dirfd, path, buf, sizeof(buf));
+
+  if (size == -1) {
+    return false;
+  }
+
+  parse_rollup(buf, size, rollup);
+  return true;
+}
+
+void parse_procio(const char *data, size_t size, procio_t *io) {
+  memset(io, 0, sizeof(*io));
+
+  each_value(data, size, [io](const char *key, size_t key_size,
+                              uint64_t value) {
+    if (is_key(key, key_size, "rchar")) {
+      io->rchar = value;
+    } else if (is_key(key, key_size, "wchar")) {
+      io->wchar = value;
+    } else if (is_key(key, key_size, "syscr")) {
+      io->syscr = value;
+    } else if (is_key(key, key_size, "syscw")) {
+      io->syscw = value;
+    } else if (is_key(key, key_size, "read_bytes")) {
+      io->read_bytes = value;
+    } else if (is_key(key, key_size, "write_bytes")) {
+      io->write_bytes = value;
+    }
+  });
+}
+
+bool read_procio(int dirfd, const char *path, procio_t *io) {
+  char buf[IO_SIZE];
+  ssize_t size = read_file(dirfd, path, buf, sizeof(buf));
+
+  if (size == -1) {
+    return false;
+  }
+
+  parse_procio(buf, size, io);
+  return true;
+}
+
+}  // namespace pl
@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_UNIX_PROCSTAT_H_
+#define SRC_UNIX_PROCSTAT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pl {
+
+/**
+ * max length of `comm` including trailing zero,
+ * `TASK_COMM_LEN` is 16, but kernel workers may report longer names
+ */
+static const size_t COMM_SIZE = 64;
+
+/**
+ * fields of `/proc/$pid/stat`, times are in clock ticks
+ */
+struct procstat_t {
+  uint32_t pid;
+  char comm[COMM_SIZE];
+  char state;
+  uint32_t ppid;
+  uint64_t utime;
+  uint64_t stime;
+  int32_t priority;
+  int32_t nice;
+  uint32_t threads;
+  uint64_t uptime;
+  uint64_t vsize;
+  uint64_t rss;
+};
+
+/**
+ * memory of `/proc/$pid/smaps_rollup`, in kB
+ */
+struct rollup_t {
+  uint64_t pss;
+  uint64_t uss;  // Private_Clean + Private_Dirty
+  uint64_t shared;  // Shared_Clean + Shared_Dirty
+  uint64_t swap;
+};
+
+/**
+ * counters of `/proc/$pid/io`
+ */
+struct procio_t {
+  uint64_t rchar;
+  uint64_t wchar;
+  uint64_t syscr;
+  uint64_t syscw;
+  uint64_t read_bytes;
+  uint64_t write_bytes;
+};
+
+/**
+ * parse the content of `/proc/$pid/stat` in a single pass,
+ * return false when data is malformed
+ */
+bool parse_procstat(const char *data, size_t size, procstat_t *pstat);
+
+/**
+ * read and parse `/proc/$pid/stat` with a single `read`,
+ * `path` is resolved relative to `dirfd` like `openat` does.
+ * Return false when the file can't be read or parsed
+ */
+bool read_procstat(int dirfd, const char *path, procstat_t *pstat);
+
+/**
+ * parse `Key: value kB` lines of `smaps_rollup`,
+ * `VmSwap` of `status` is read as `swap`, missing keys are zero
+ */
+void parse_rollup(const char *data, size_t size, rollup_t *rollup);
+
+/**
+ * read and parse `smaps_rollup` or `status` relative to `dirfd`,
+ * return false when the file can't be read
+ */
+bool read_rollup(int dirfd, const char *path, rollup_t *rollup);
+
+/**
+ * parse `/proc/$pid/io`, missing keys are zero
+ */
+void parse_procio(const char *data, size_t size, procio_t *io);
+
+/**
+ * read and parse `/proc/$pid/io` relative to `dirfd`,
+ * return false when the file can't be read
+ */
+bool read_procio(int dirfd, const char *path, procio_t *io);
+
+}  // namespace pl
+
+#endif  // SRC_UNIX_PROCSTAT_H_
@@ -10,85 +10,252 @@
 #include <sys/stat.h>
 #include <sys/types.h>  // ssize_t
 #include <sys/time.h>
-#include <dirent.h>
+#include <sys/syscall.h>
 #include <errno.h>
-#include <unistd.h>  // read, basename
+#include <unistd.h>  // read
 #include <fcntl.h>
 #include <pwd.h>
-#include <libgen.h>  // readlink
 #include <stdio.h>
 
+#include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <exception>
+#include <limits>
+#include <mutex>  // NOLINT(build/c++11)
+#include <stdexcept>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "filter.h"  // NOLINT(build/include)
+#include "metadata.h"  // NOLINT(build/include)
+#include "stats.h"  // NOLINT(build/include)
+#include "unix/procstat.h"  // NOLINT(build/include)
+
 using pl::process;
+using pl::procstat_t;
+using pl::probe;
 
 #pragma GCC diagnostic ignored "-Wunused-result";
 
-struct procstat_t {
-  uint32_t pid;
-  uint32_t ppid;
-  uint32_t threads;
-  int32_t  priority;
-  uint64_t uptime;
-
-  uint64_t utime;
-  uint64_t stime;
-};
-
 /**
  * get memory page size in bytes
  */
 static int page_size = sysconf(_SC_PAGE_SIZE);
 
-static int hertz = 0;
+/**
+ * number of clock ticks per second
+ */
+static const uint64_t hertz = sysconf(_SC_CLK_TCK);
+
+/**
+ * convert clock ticks to milliseconds
+ */
+static inline uint64_t ticks_to_ms(uint64_t t) {
+  return t * 1000 / hertz;
+}
 
 /**
- * convert clock ticks to seconds
+ * parse the name of the pid dir, return 0 for other entries,
+ * `.`, `..`, `self` and the like are rejected by the first byte
  */
-static inline uint64_t adjust_time(uint64_t t) {
-  if (hertz == 0) {
-    hertz = sysconf(_SC_CLK_TCK);
+static inline uint32_t parse_pid(const char *name) {
+  if (*name < '1' || *name > '9') {
+    return 0;
+  }
+
+  uint32_t pid = 0;
+
+  for (; *name; ++name) {
+    if (*name < '0' || *name > '9') {
+      return 0;
+    }
+
+    pid = pid * 10 + (*name - '0');
   }
 
-  return t / hertz;
+  return pid;
 }
 
 /**
- * check if provided string is valid number
+ * write the name of the pid dir to `buf` of at least 11 chars
  */
-static inline bool is_pid(const char *data, size_t s) {
-  return std::all_of (data, data + s, ::isdigit);
+static inline const char *pid_name(uint32_t pid, char *buf) {
+  char digits[10];
+  size_t count = 0;
+
+  do {
+    digits[count++] = '0' + pid % 10;
+    pid /= 10;
+  } while (pid != 0);
+
+  for (size_t i = 0; i < count; ++i) {
+    buf[i] = digits[count - i - 1];
+  }
+
+  buf[count] = '\0';
+  return buf;
 }
 
 /**
- * read provided directory and return dir list
+ * owner of the file descriptor
  */
-template<class FilterPredicate>
-static std::vector<dirent> ls(const char *path, FilterPredicate filter) {
-  auto dir = opendir(path);
-  struct dirent *entry;
-  std::vector<dirent> dirlist;
+struct descriptor {
+  // the call which has returned `fd` is counted too
+  explicit descriptor(int fd) : fd(fd) {
+    ++pl::thread_io.syscalls;
+  }
 
-  if (!dir) {
-    perror("can't read dir");
-    throw std::bad_alloc();
+  ~descriptor() {
+    if (fd != -1) {
+      close(fd);
+      ++pl::thread_io.syscalls;
+    }
   }
 
-  while ((entry = readdir(dir)) != NULL) {
-    if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
-      continue;
+  int fd;
+};
+
+/**
+ * default root of procfs
+ */
+static const char PROCFS[] = "/proc";
+
+/**
+ * open the root of procfs
+ */
+static int openroot(const char *root) {
+  int fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  if (fd == -1) {
+    throw std::runtime_error(std::string("can't open ") + root);
+  }
+
+  return fd;
+}
+
+/**
+ * descriptor of `/proc`, it's opened once and kept for the process lifetime,
+ * so per-process paths are resolved relative to it
+ */
+static int procfs() {
+  static const int fd = openroot(PROCFS);
+  return fd;
+}
+
+/**
+ * the process has exited while it's read, so it's dropped from the snapshot
+ * instead of failing the whole scan
+ */
+struct process_exited : std::runtime_error {
+  process_exited() : std::runtime_error("the process has exited") {}
+};
+
+/**
+ * check errno of the failed call for signs of the exited process:
+ * its directory is gone or the kernel has already released it
+ */
+static inline bool exited() {
+  return errno == ENOENT || errno == ESRCH;
+}
+
+/**
+ * an optional file of the process has failed, `ENOENT` may mean
+ * the file doesn't exist at all, e.g. `exe` of kernel threads,
+ * so `stat` is checked to tell the exited process
+ */
+static void check_exited(int dirfd) {
+  if (!exited()) {
+    return;
+  }
+
+  ++pl::thread_io.syscalls;
+
+  if (faccessat(dirfd, "stat", F_OK, 0) == -1 && exited()) {
+    throw process_exited();
+  }
+}
+
+/**
+ * record of `getdents64`, glibc declares it only since 2.30
+ */
+struct dirent64_t {
+  uint64_t d_ino;
+  int64_t d_off;
+  uint16_t d_reclen;
+  uint8_t d_type;
+  char d_name[1];
+};
+
+/**
+ * size of the `getdents64` buffer, `/proc` of 100k processes
+ * takes a few dozen calls
+ */
+static const size_t DENTS_SIZE = 64 * 1024;
+
+/**
+ * read pids of the provided directory in one pass over `getdents64`
+ * records, so names aren't copied. The list is sorted
+ */
+static std::vector<uint32_t> ls(int dirfd) {
+  // the buffer is reused by all listings of the thread
+  static thread_local std::unique_ptr<char[]> buffer;
+
+  if (!buffer) {
+    buffer.reset(new char[DENTS_SIZE]);
+  }
+
+  // own open file description, so concurrent listings don't share offset
+  descriptor dir(openat(dirfd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+  std::vector<uint32_t> pids;
+
+  if (dir.fd == -1 && exited()) {
+    throw process_exited();
+  }
+
+  if (dir.fd == -1) {
+    throw std::runtime_error("can't read dir");
+  }
+
+  for (;;) {
+    int64_t size = syscall(SYS_getdents64, dir.fd, buffer.get(), DENTS_SIZE);
+    ++pl::thread_io.syscalls;
+
+    if (size == -1 && exited()) {
+      throw process_exited();
+    }
+
+    if (size == -1) {
+      throw std::runtime_error("can't read dir");
+    }
+
+    if (size == 0) {
+      break;
     }
 
-    if (filter(entry)) {
-      dirlist.push_back(*entry);  // copy dirent
+    for (int64_t offset = 0; offset < size;) {
+      auto entry = reinterpret_cast<const dirent64_t *>(buffer.get() + offset);
+      uint32_t pid = parse_pid(entry->d_name);
+
+      if (pid != 0) {
+        pids.push_back(pid);
+      }
+
+      offset += entry->d_reclen;
     }
   }
 
-  closedir(dir);
-  return dirlist;
+  // `/proc` is listed in pid order, other file systems may be not
+  if (!std::is_sorted(pids.begin(), pids.end())) {
+    std::sort(pids.begin(), pids.end());
+  }
+
+  return pids;
 }
 
 /**
@@ -101,11 +268,13 @@ static ssize_t xread(int fd, void *buf, size_t count) {
   size_t alreadyRead = 0;
   for(;;) {
     ssize_t res = read(fd, buf, count);
+    ++pl::thread_io.syscalls;
      if (res == -1 && errno == EINTR) continue;
     if (res > 0) {
        buf = ((char*)buf)+res;
       count -= res;
       alreadyRead += res;
+      pl::thread_io.bytes += res;
     }
      if (res == -1) return -1;
      if (count == 0 || res == 0) return alreadyRead;
@@ -113,23 +282,31 @@ static ssize_t xread(int fd, void *buf, size_t count) {
 }
 
 /**
- * read process cmdline
+ * read process cmdline to the arena
  */
-static std::string cmdline(const char* pid) {
-  char path[32];
-  snprintf(path, sizeof(path), "/proc/%s/cmdline", pid);
+static pl::string_ref cmdline(int dirfd, pl::string_arena *strings) {
+  int fd = openat(dirfd, "cmdline", O_RDONLY | O_CLOEXEC);
+  ++pl::thread_io.syscalls;
 
-  int fd = open(path, O_RDONLY);
+  if (fd == -1 && exited()) {
+    throw process_exited();
+  }
 
   if (fd == -1) {
-    return "";
+    return pl::string_ref();
   }
 
   const int MAX_READ = 4096;
   char command[MAX_READ + 1];
   int amtRead = xread(fd, command, MAX_READ);
+  int error = errno;
 
   close(fd);
+  ++pl::thread_io.syscalls;
+
+  if (amtRead == -1 && (error == ENOENT || error == ESRCH)) {
+    throw process_exited();
+  }
 
   if (amtRead > 0) {
     for (int i = 0; i < amtRead; ++i) {
@@ -140,30 +317,40 @@ static std::string cmdline(const char* pid) {
   } else {
     // This is probably kernel thread.
     // @link https://github.com/hishamhm/htop/blob/47cf1532b0c9fbc70bada5022a7db07d3cc4811a/linux/LinuxProcessList.c#L692
-    return "";
+    return pl::string_ref();
   }
 
-  return std::string(command, amtRead - 1);
+  return strings->store(command, amtRead - 1);
 }
 
 /**
- * read process owner name
+ * read uid of the process owner
  */
-static std::string owner(const char *pid) {
+static uid_t owner(int dirfd) {
   struct stat sstat;
-  struct passwd usrpwd, *res;
-  char buf[1024];
-  int bufsize = sizeof(buf);
-  std::string username;
+  ++pl::thread_io.syscalls;
 
-  char path[32];
-  snprintf(path, sizeof(path), "/proc/%s", pid);
+  if (fstatat(dirfd, "", &sstat, AT_EMPTY_PATH) == -1) {
+    if (exited()) {
+      throw process_exited();
+    }
 
-  if (stat(path, &sstat) == -1) {
     throw std::runtime_error("can't stat dir");
   }
 
-  getpwuid_r(sstat.st_uid, &usrpwd, buf, bufsize, &res);
+  return sstat.st_uid;
+}
+
+/**
+ * resolve user name, it may cost an IPC round-trip with NSS
+ */
+static std::string getusername(uid_t uid) {
+  struct passwd usrpwd, *res;
+  char buf[1024];
+  int bufsize = sizeof(buf);
+  std::string username;
+
+  getpwuid_r(uid, &usrpwd, buf, bufsize, &res);
 
   if (res != NULL) {
     username = usrpwd.pw_name;
@@ -173,170 +360,807 @@ static std::string owner(const char *pid) {
 }
 
 /**
- * read absolute path to the process
- * and process executable file name
+ * resolve uid of the user name, return false for unknown user
+ */
+static bool getuserid(const std::string &name, uid_t *uid) {
+  struct passwd usrpwd, *res;
+  char buf[1024];
+  int bufsize = sizeof(buf);
+
+  getpwnam_r(name.c_str(), &usrpwd, buf, bufsize, &res);
+
+  if (res == NULL) {
+    return false;
+  }
+
+  *uid = usrpwd.pw_uid;
+  return true;
+}
+
+/**
+ * user name resolved at the specified time
+ */
+struct username_entry {
+  std::string name;
+  std::chrono::steady_clock::time_point resolved;
+};
+
+/**
+ * user names cache shared by all snapshots and threads
+ */
+static std::mutex usernames_lock;
+static std::unordered_map<uid_t, username_entry> usernames;
+
+/**
+ * resolve user name through the cache,
+ * entries older than `ttl` ms are resolved again
  */
-static void procpath(const char *pid, process *proc) {
-  char syspath[32];
-  snprintf(syspath, sizeof(syspath), "/proc/%s/exe", pid);
+static std::string username(uid_t uid, uint32_t ttl) {
+  if (ttl == 0) {
+    return getusername(uid);
+  }
 
+  auto now = std::chrono::steady_clock::now();
+  auto ttl_ms = std::chrono::milliseconds(ttl);
+
+  {
+    std::lock_guard<std::mutex> guard(usernames_lock);
+    auto entry = usernames.find(uid);
+
+    if (entry != usernames.end() && now - entry->second.resolved < ttl_ms) {
+      return entry->second.name;
+    }
+  }
+
+  // don't hold the lock while NSS is working
+  std::string name = getusername(uid);
+
+  std::lock_guard<std::mutex> guard(usernames_lock);
+  usernames[uid] = username_entry { name, now };
+
+  return name;
+}
+
+/**
+ * read absolute path to the process
+ */
+static void procpath(int dirfd, process *proc, pl::string_interner *paths) {
   char path[4096+1];
-  ssize_t size = readlink(syspath, path, sizeof(path) - 1);
+  ssize_t size = readlinkat(dirfd, "exe", path, sizeof(path) - 1);
+  ++pl::thread_io.syscalls;
 
   if (size == -1) {
+    check_exited(dirfd);
     return;
   }
 
-  path[size] = '\0';
+  proc->path = paths->intern(path, size);
+}
+
+/**
+ * `comm` and the inode of the executable, a change of them means
+ * the process has called `execve`. Kernel threads and processes
+ * of other users have no readable `exe`, so only `comm` is checked
+ */
+static pl::exec_signature exec_signature(int dirfd, const procstat_t &pstat) {
+  pl::exec_signature signature;
+  struct stat sstat;
+
+  signature.comm = pstat.comm;
+  ++pl::thread_io.syscalls;
 
-  proc->path = std::string(path);
-  proc->name = std::string(basename(path));
+  if (fstatat(dirfd, "exe", &sstat, 0) == 0) {
+    signature.dev = sstat.st_dev;
+    signature.ino = sstat.st_ino;
+  } else {
+    check_exited(dirfd);
+  }
+
+  return signature;
 }
 
 /**
  * read `/proc/$pid/stat`
  */
-static void procstat(const char *fpid, procstat_t *pstat) {
-  char path[32];
-  snprintf(path, sizeof(path), "/proc/%s/stat", fpid);
+static void procstat(int dirfd, procstat_t *pstat) {
+  // a malformed file fails without errno
+  errno = 0;
 
-  auto fd = fopen(path, "r");
+  if (!pl::read_procstat(dirfd, "stat", pstat)) {
+    if (exited()) {
+      throw process_exited();
+    }
 
-  if (fd == NULL) {
     throw std::runtime_error("can't open stat");
   }
+}
 
-  fscanf(fd, "%d", &pstat->pid);  // (1)
-  fscanf(fd, " %*s");
-  fscanf(fd, " %*c");
-  fscanf(fd, " %d", &pstat->ppid);  // (4)
-  fscanf(fd, " %*d");
-  fscanf(fd, " %*d");
-  fscanf(fd, " %*d");
-  fscanf(fd, " %*d");
-  fscanf(fd, " %*u");
-  fscanf(fd, " %*u");
-  fscanf(fd, " %*u");
-  fscanf(fd, " %*u");
-  fscanf(fd, " %*u");
-  fscanf(fd, " %lu", &pstat->utime);  // (14)
-  fscanf(fd, " %lu", &pstat->stime);  // (15)
-  fscanf(fd, " %*d");
-  fscanf(fd, " %*d");
-  fscanf(fd, " %d", &pstat->priority);  // (18)
-  fscanf(fd, " %*d");
-  fscanf(fd, " %d", &pstat->threads);  // (20)
-  fscanf(fd, " %*d");
-  fscanf(fd, " %lu", &pstat->uptime);  // (22)
-
-  fclose(fd);
-
-  pstat->uptime = adjust_time(pstat->uptime);
-  pstat->utime = adjust_time(pstat->utime);
-  pstat->stime = adjust_time(pstat->stime);
-}
-
-static void procmem(const char *pid, process *proc) {
-  char path[32];
-  snprintf(path, sizeof(path), "/proc/%s/statm", pid);
-
-  auto fd = fopen(path, "r");
-
-  if (fd == NULL) {
+/**
+ * read `/proc/$pid/statm`
+ */
+static void procmem(int dirfd, process *proc) {
+  descriptor statm(openat(dirfd, "statm", O_RDONLY | O_CLOEXEC));
+
+  char buf[128];
+  ssize_t size = (statm.fd == -1) ?
+    -1 : xread(statm.fd, buf, sizeof(buf) - 1);
+
+  if (size == -1 && exited()) {
+    throw process_exited();
+  }
+
+  if (size <= 0) {
     throw std::runtime_error("can't open `/proc/$pid/statm`");
   }
 
-  fscanf(fd, "%lu %lu", &proc->vmem, &proc->pmem);
+  buf[size] = '\0';
+
+  char *end;
+  proc->vmem = strtoull(buf, &end, 10) * page_size;
+  proc->pmem = strtoull(end, NULL, 10) * page_size;
+}
+
+/**
+ * read `/proc/$pid/smaps_rollup`, the kernel walks all mappings
+ * of the process to build it, so it's the most expensive file.
+ * Kernels before 4.14 have no `smaps_rollup`, then only swap is read
+ * from `status`. It's readable only for own processes without
+ * CAP_SYS_PTRACE, on EACCES the fields stay zero
+ */
+static void procrollup(int dirfd, process *proc) {
+  struct pl::rollup_t rollup;
 
-  proc->vmem *= page_size;
-  proc->pmem *= page_size;
+  if (!pl::read_rollup(dirfd, "smaps_rollup", &rollup) &&
+      (errno != ENOENT || !pl::read_rollup(dirfd, "status", &rollup))) {
+    check_exited(dirfd);
+    return;
+  }
 
-  fclose(fd);
+  proc->pss = rollup.pss * 1024;
+  proc->uss = rollup.uss * 1024;
+  proc->swap = rollup.swap * 1024;
+  proc->shared = rollup.shared * 1024;
 }
 
-namespace pl {
+/**
+ * read `/proc/$pid/io`, it's readable only for own processes
+ * without CAP_SYS_PTRACE, then counters are zero
+ */
+static void procio(int dirfd, process *proc) {
+  struct pl::procio_t io;
 
-  /**
-   * main function
-   */
-  list_t list(const struct process_fields &requested_fields) {
-    list_t proclist;
-    struct sysinfo sys_info;
+  if (!pl::read_procio(dirfd, "io", &io)) {
+    check_exited(dirfd);
+    return;
+  }
 
-    if (sysinfo(&sys_info) != 0) {
-      throw new std::logic_error("`sysinfo` return non-zero code");
+  proc->read_bytes = io.read_bytes;
+  proc->write_bytes = io.write_bytes;
+  proc->rchar = io.rchar;
+  proc->wchar = io.wchar;
+  proc->syscr = io.syscr;
+  proc->syscw = io.syscw;
+}
+
+/**
+ * read the boot time in ms since epoch from `btime` of `/proc/stat`
+ */
+static uint64_t read_boottime(int procfd) {
+  descriptor stat(openat(procfd, "stat", O_RDONLY | O_CLOEXEC));
+  std::string content;
+  char buf[4096];
+  ssize_t size;
+
+  while (stat.fd != -1 && (size = xread(stat.fd, buf, sizeof(buf))) > 0) {
+    content.append(buf, size);
+  }
+
+  auto pos = content.find("\nbtime ");
+
+  if (pos != std::string::npos) {
+    return strtoull(content.c_str() + pos + 7, NULL, 10) * 1000;
+  }
+
+  struct sysinfo sys_info;
+  struct timeval tv;
+
+  sysinfo(&sys_info);
+  gettimeofday(&tv, NULL);
+
+  return (tv.tv_sec - sys_info.uptime) * 1000L;
+}
+
+/**
+ * the boot time of `/proc` is read once, so start times of the process
+ * stay the same between snapshots and can be used as a part of
+ * the process identity
+ */
+static uint64_t boottime(int procfd) {
+  static const uint64_t btime = read_boottime(procfd);
+  return btime;
+}
+
+/**
+ * snapshot-wide values shared by every reader thread
+ */
+struct scan_context {
+  const struct pl::process_fields *fields;
+  const struct pl::process_filter *filter;
+
+  // uid filter, `owner` filter is resolved to uid as well
+  bool has_uid;
+  uid_t uid;
+
+  // pids are requested explicitly, so `/proc` isn't listed
+  bool direct;
+
+  int procfd;
+  uint32_t owner_ttl;
+  struct sysinfo sys_info;
+  uint64_t boottime;
+
+  // path and cmdline kept between snapshots, null when disabled
+  pl::metadata_cache *cache;
+  uint32_t cache_size;
+};
+
+/**
+ * state of one reader thread
+ */
+struct reader {
+  // strings of processes read by the thread
+  std::shared_ptr<pl::string_arena> strings;
+  pl::string_interner interned;
+
+  pl::scan_stats *stats;
+
+  reader(size_t bytes, pl::scan_stats *stats)
+  : strings(std::make_shared<pl::string_arena>()),
+    interned(strings.get()),
+    stats(stats) {
+    strings->reserve(bytes);
+  }
+};
+
+/**
+ * rough size of strings of one process, so the arena
+ * of a batch is usually allocated at once
+ */
+static size_t string_bytes(const pl::process_fields &fields) {
+  return (fields.name ? 16 : 0) + (fields.path ? 64 : 0) +
+    (fields.cmdline ? 128 : 0);
+}
+
+/**
+ * read `/proc/$pid/task/$tid/stat` of every thread
+ */
+static void proctasks(int dirfd, const scan_context &ctx, process *proc) {
+  descriptor taskdir(openat(dirfd, "task", O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+
+  if (taskdir.fd == -1 && exited()) {
+    throw process_exited();
+  }
+
+  if (taskdir.fd == -1) {
+    return;
+  }
+
+  auto tids = ls(taskdir.fd);
+
+  proc->tasks.reserve(tids.size());
+
+  char path[16 + sizeof("/stat")];
+  int64_t now = ctx.sys_info.uptime * 1000L;
+
+  for (uint32_t tid : tids) {
+    snprintf(path, sizeof(path), "%u/stat", tid);
+
+    struct procstat_t tstat;
+
+    // the thread has exited
+    if (!pl::read_procstat(taskdir.fd, path, &tstat)) {
+      continue;
     }
 
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
+    pl::thread_info thread;
+    thread.tid = tstat.pid;
+    thread.name = tstat.comm;
+    thread.state = tstat.state;
+    thread.starttime = ctx.boottime + ticks_to_ms(tstat.uptime);
+    thread.utime = ticks_to_ms(tstat.utime);
+    thread.stime = ticks_to_ms(tstat.stime);
 
-    uint64_t now = tv.tv_sec * 1000L + tv.tv_usec / 1000L;
+    int64_t elapsed = now - ticks_to_ms(tstat.uptime);
+    double cpu = static_cast<double>(thread.utime + thread.stime);
+    thread.cpu = (elapsed <= 0) ? 0 : NORMAL(cpu / elapsed * 100, 0.0, 100.0);
 
-    auto dirlist = ls("/proc", [](const struct dirent *entry) {
-      return is_pid(entry->d_name, strlen(entry->d_name));
-    });
+    proc->tasks.push_back(std::move(thread));
+  }
+}
 
-    for (auto entry : dirlist) {
-      struct process proc;
+/**
+ * check the name filter, `comm` is tried first, the executable file name
+ * is read only when `comm` doesn't match and may be truncated
+ */
+static bool match_name(int dirfd, const pl::process_filter &filter,
+                       const procstat_t &pstat, process *proc,
+                       reader *self) {
+  if (pl::glob(filter.name.c_str(), pstat.comm)) {
+    return true;
+  }
 
-      struct procstat_t pstat;
-      procstat(entry.d_name, &pstat);
+  // the kernel truncates `comm` to 15 chars
+  if (strlen(pstat.comm) < 15) {
+    return false;
+  }
 
-      if (requested_fields.cmdline) {
-        proc.cmdline = cmdline(entry.d_name);
-      }
+  {
+    probe measure(self->stats, pl::PHASE_PATH);
+    procpath(dirfd, proc, &self->interned);
+  }
 
-      if (requested_fields.owner) {
-        proc.owner = owner(entry.d_name);
-      }
+  const char *slash = strrchr(proc->path.c_str(), '/');
+  return pl::glob(filter.name.c_str(), slash ? slash + 1 : proc->path.c_str());
+}
 
-      if (requested_fields.path || requested_fields.name) {
-        procpath(entry.d_name, &proc);
-      }
+/**
+ * count the process filtered out
+ */
+static inline bool skipped(pl::scan_stats *stats) {
+  if (stats) {
+    ++stats->skipped;
+  }
 
-      if (requested_fields.pid) {
-        proc.pid = pstat.pid;
-      }
+  return false;
+}
 
-      if (requested_fields.ppid) {
-        proc.ppid = pstat.ppid;
-      }
+/**
+ * count the process which has exited before it's read
+ */
+static inline bool vanished(pl::scan_stats *stats) {
+  if (stats) {
+    ++stats->vanished;
+  }
 
-      if (requested_fields.threads) {
-        proc.threads = pstat.threads;
-      }
+  return false;
+}
 
-      if (requested_fields.priority) {
-        proc.priority = pstat.priority;
+/**
+ * read all requested fields of the single process,
+ * return false when the process doesn't pass the filter.
+ * Filters are checked as soon as their data is read.
+ */
+static bool read_process(uint32_t pid, const scan_context &ctx,
+                         process *proc, reader *self) {
+  const struct pl::process_fields &requested_fields = *ctx.fields;
+  const struct pl::process_filter &filter = *ctx.filter;
+  pl::scan_stats *stats = self->stats;
+  char buf[16];
+  const char *name = pid_name(pid, buf);
+
+  // check owner before anything is opened,
+  // so excluded processes cost a single syscall
+  if (ctx.has_uid) {
+    probe measure(stats, pl::PHASE_OWNER);
+    struct stat sstat;
+    ++pl::thread_io.syscalls;
+
+    if (fstatat(ctx.procfd, name, &sstat, 0) == -1) {
+      if (exited()) {
+        return vanished(stats);
       }
 
-      if (requested_fields.starttime) {
-        proc.starttime = now - (sys_info.uptime * 1000L - pstat.uptime * 1000L);
-      }
+      throw std::runtime_error("can't stat dir");
+    }
 
-      if (requested_fields.vmem || requested_fields.pmem) {
-        procmem(entry.d_name, &proc);
-      }
+    if (sstat.st_uid != ctx.uid) {
+      return skipped(stats);
+    }
 
-      // @link http://stackoverflow.com/a/16736599/1556249
-      if (requested_fields.cpu) {
-        uint64_t elapsed = sys_info.uptime - pstat.uptime;
-        double cpu = static_cast<double>(pstat.utime + pstat.stime) / elapsed;
+    proc->uid = sstat.st_uid;
+  }
 
-        proc.cpu = (elapsed == 0) ? 0 : NORMAL(cpu * 100, 0.0f, 100.0f);
-      }
+  // every file of the process is opened relative to its directory,
+  // so all of them belong to the same process even if the pid is reused
+  descriptor dir(openat(ctx.procfd, name, O_PATH | O_DIRECTORY | O_CLOEXEC));
 
-      if (requested_fields.utime) {
-        proc.utime = pstat.utime * 1000;
-      }
+  if (dir.fd == -1) {
+    if (exited()) {
+      return vanished(stats);
+    }
+
+    throw std::runtime_error("can't open `/proc/$pid`");
+  }
+
+  struct procstat_t pstat;
+
+  {
+    probe measure(stats, pl::PHASE_STAT);
+    procstat(dir.fd, &pstat);
+  }
+
+  if (filter.has_ppid && pstat.ppid != filter.ppid) {
+    return skipped(stats);
+  }
+
+  if (!filter.name.empty() &&
+      !match_name(dir.fd, filter, pstat, proc, self)) {
+    return skipped(stats);
+  }
+
+  if (requested_fields.name || requested_fields.path ||
+      requested_fields.cmdline || requested_fields.owner) {
+    proc->strings = self->strings;
+  }
+
+  // cached strings are valid until `execve`
+  pl::process_key key(pstat.pid, pstat.uptime);
+  pl::exec_signature signature;
+  pl::process_metadata cached;
+  bool cacheable = ctx.cache &&
+    (requested_fields.cmdline || requested_fields.path);
+
+  if (cacheable) {
+    probe measure(stats, pl::PHASE_CACHE);
+    signature = exec_signature(dir.fd, pstat);
+    ctx.cache->lookup(key, signature, &self->interned, self->strings.get(),
+      &cached);
+  }
+
+  if (requested_fields.cmdline && cached.has_cmdline) {
+    proc->cmdline = cached.cmdline;
+  } else if (requested_fields.cmdline) {
+    probe measure(stats, pl::PHASE_CMDLINE);
+    proc->cmdline = cmdline(dir.fd, self->strings.get());
+  }
+
+  if (requested_fields.owner || requested_fields.uid) {
+    probe measure(stats, pl::PHASE_OWNER);
+
+    if (!ctx.has_uid) {
+      proc->uid = owner(dir.fd);
+    }
+
+    if (requested_fields.owner) {
+      proc->owner = self->interned.intern(username(proc->uid, ctx.owner_ttl));
+    }
+  }
+
+  if (requested_fields.path && proc->path.empty() && cached.has_path) {
+    proc->path = cached.path;
+  } else if (requested_fields.path && proc->path.empty()) {
+    probe measure(stats, pl::PHASE_PATH);
+    procpath(dir.fd, proc, &self->interned);
+  }
+
+  if (cacheable && ((requested_fields.cmdline && !cached.has_cmdline) ||
+      (requested_fields.path && !cached.has_path))) {
+    pl::process_metadata read;
+    read.has_path = requested_fields.path;
+    read.has_cmdline = requested_fields.cmdline;
+    read.path = proc->path;
+    read.cmdline = proc->cmdline;
+
+    ctx.cache->store(key, signature, read, ctx.cache_size);
+  }
+
+  // `comm` is already read, so the name doesn't need `readlink`,
+  // it's the same whether `path` is requested or not
+  if (requested_fields.name) {
+    proc->name = self->interned.intern(pstat.comm, strlen(pstat.comm));
+  }
+
+  if (requested_fields.pid) {
+    proc->pid = pstat.pid;
+  }
+
+  if (requested_fields.ppid) {
+    proc->ppid = pstat.ppid;
+  }
+
+  if (requested_fields.threads) {
+    proc->threads = pstat.threads;
+  }
+
+  if (requested_fields.priority) {
+    proc->priority = pstat.priority;
+  }
+
+  if (requested_fields.starttime) {
+    proc->starttime = ctx.boottime + ticks_to_ms(pstat.uptime);
+  }
+
+  if (requested_fields.vmem || requested_fields.pmem) {
+    probe measure(stats, pl::PHASE_MEM);
+    procmem(dir.fd, proc);
+  }
 
-      if (requested_fields.stime) {
-        proc.stime = pstat.stime * 1000;
+  // @link http://stackoverflow.com/a/16736599/1556249
+  if (requested_fields.cpu) {
+    int64_t elapsed = ctx.sys_info.uptime * 1000L - ticks_to_ms(pstat.uptime);
+    double cpu = static_cast<double>(ticks_to_ms(pstat.utime + pstat.stime));
+
+    proc->cpu = (elapsed <= 0) ? 0 : NORMAL(cpu / elapsed * 100, 0.0f, 100.0f);
+  }
+
+  if (requested_fields.utime) {
+    proc->utime = ticks_to_ms(pstat.utime);
+  }
+
+  if (requested_fields.stime) {
+    proc->stime = ticks_to_ms(pstat.stime);
+  }
+
+  // filters are already checked, so only matching processes get here
+  if (requested_fields.pss || requested_fields.uss ||
+      requested_fields.swap || requested_fields.shared) {
+    probe measure(stats, pl::PHASE_ROLLUP);
+    procrollup(dir.fd, proc);
+  }
+
+  if (requested_fields.read_bytes || requested_fields.write_bytes ||
+      requested_fields.rchar || requested_fields.wchar ||
+      requested_fields.syscr || requested_fields.syscw) {
+    probe measure(stats, pl::PHASE_IO);
+    procio(dir.fd, proc);
+  }
+
+  if (requested_fields.tasks) {
+    probe measure(stats, pl::PHASE_TASKS);
+    proctasks(dir.fd, ctx, proc);
+  }
+
+  return true;
+}
+
+/**
+ * read the single process, the process exited between the listing
+ * of `/proc` and the last read is dropped with all fields read so far
+ */
+static bool scan(uint32_t pid, const scan_context &ctx, process *proc,
+                 reader *self) {
+  try {
+    return read_process(pid, ctx, proc, self);
+  } catch (const process_exited &) {
+    return vanished(self->stats);
+  }
+}
+
+/**
+ * contiguous range of the pid list owned by one reader thread
+ */
+struct shard {
+  std::atomic<size_t> next;
+  size_t end;
+};
+
+/**
+ * number of entries claimed at once from a shard
+ */
+static const size_t CHUNK_SIZE = 32;
+
+/**
+ * claim the next chunk of the shard, return false when it's drained
+ */
+static inline bool claim(shard *sh, size_t *begin, size_t *end) {
+  size_t i = sh->next.fetch_add(CHUNK_SIZE, std::memory_order_relaxed);
+
+  if (i >= sh->end) {
+    return false;
+  }
+
+  *begin = i;
+  *end = std::min(i + CHUNK_SIZE, sh->end);
+  return true;
+}
+
+/**
+ * read processes on several threads
+ * every thread drains its own shard first and then steals chunks
+ * from the others, so a few slow readers don't stall the whole scan.
+ * Each process is written into the slot of its pid, so the result
+ * keeps the ascending pid order. Every thread has its own
+ * string arena and stats, stats are merged once at the end.
+ */
+static void parallel_scan(const uint32_t *pids, size_t count,
+                          const scan_context &ctx,
+                          uint32_t concurrency,
+                          pl::list_t *proclist,
+                          std::vector<uint8_t> *matched,
+                          pl::scan_stats *stats) {
+  std::vector<shard> shards(concurrency);
+  size_t per_shard = (count + concurrency - 1) / concurrency;
+
+  for (uint32_t i = 0; i < concurrency; ++i) {
+    shards[i].next = std::min(i * per_shard, count);
+    shards[i].end = std::min((i + 1) * per_shard, count);
+  }
+
+  std::exception_ptr error;
+  std::atomic_flag error_lock = ATOMIC_FLAG_INIT;
+  std::atomic<bool> failed(false);
+  std::mutex stats_lock;
+
+  auto worker = [&shards, pids, &ctx, &error, &error_lock, &failed,
+                 &stats_lock, count, concurrency, proclist, matched,
+                 stats](uint32_t self) {
+    pl::scan_stats local;
+    reader own(string_bytes(*ctx.fields) * (count / concurrency),
+      stats ? &local : NULL);
+
+    for (uint32_t n = 0; n < concurrency && !failed; ++n) {
+      shard *sh = &shards[(self + n) % concurrency];
+      size_t begin, end;
+
+      while (!failed && claim(sh, &begin, &end)) {
+        try {
+          for (size_t i = begin; i < end; ++i) {
+            (*matched)[i] = scan(pids[i], ctx, &proclist->at(i),
+              &own);
+          }
+        } catch (...) {
+          if (!error_lock.test_and_set()) {
+            error = std::current_exception();
+          }
+
+          failed = true;
+        }
       }
+    }
 
-      proclist.push_back(proc);
+    if (stats) {
+      std::lock_guard<std::mutex> lock(stats_lock);
+      stats->merge(local);
     }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(concurrency - 1);
+
+  for (uint32_t i = 1; i < concurrency; ++i) {
+    threads.emplace_back(worker, i);
+  }
+
+  worker(0);
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+/**
+ * read processes of the pids, filtered out ones are dropped
+ */
+static pl::list_t scan_entries(const uint32_t *pids, size_t count,
+                               const scan_context &ctx,
+                               uint32_t max_concurrency,
+                               pl::scan_stats *stats) {
+  pl::list_t proclist(count);
+  std::vector<uint8_t> matched(count);
+
+  size_t chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  uint32_t concurrency = static_cast<uint32_t>(
+    std::min<size_t>(max_concurrency, chunks));
+
+  if (concurrency > 1) {
+    parallel_scan(pids, count, ctx, concurrency, &proclist, &matched,
+      stats);
+  } else {
+    reader self(string_bytes(*ctx.fields) * count, stats);
+
+    for (size_t i = 0; i < count; ++i) {
+      matched[i] = scan(pids[i], ctx, &proclist[i], &self);
+    }
+  }
+
+  if (stats) {
+    stats->processes += count;
+  }
+
+  // drop filtered out processes keeping the order
+  size_t size = 0;
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!matched[i]) {
+      continue;
+    }
+
+    if (size != i) {
+      proclist[size] = std::move(proclist[i]);
+    }
+
+    ++size;
+  }
+
+  proclist.resize(size);
+  return proclist;
+}
+
+namespace pl {
+
+  /**
+   * main function
+   */
+  list_t list(const struct process_fields &requested_fields,
+              const struct list_options &options) {
+    list_t proclist;
+
+    list(requested_fields, options, std::numeric_limits<size_t>::max(),
+      [&proclist](list_t *batch) {
+        proclist.swap(*batch);
+        return true;
+      });
 
     return proclist;
   }
+
+  void list(const struct process_fields &requested_fields,
+            const struct list_options &options,
+            size_t batch_size,
+            const batch_handler &handler) {
+    const struct process_filter &filter = options.filter;
+
+    // another root, e.g. a fixture, is opened for every snapshot
+    bool custom = options.procfs != PROCFS;
+    descriptor root(custom ? openroot(options.procfs.c_str()) : -1);
+
+    scan_context ctx;
+    ctx.fields = &requested_fields;
+    ctx.filter = &filter;
+    ctx.procfd = custom ? root.fd : procfs();
+    ctx.owner_ttl = options.owner_ttl;
+    ctx.has_uid = filter.has_uid;
+    ctx.uid = filter.uid;
+    ctx.direct = !filter.pids.empty();
+    ctx.cache = NULL;
+    ctx.cache_size = options.cache_size;
+
+    if (options.cache_size != 0) {
+      ctx.cache = &pl::metadata_cache::shared();
+      ctx.cache->bind(options.procfs);
+      ctx.cache->next_epoch();
+    }
+
+    // the owner is checked by uid, so the name is resolved only once
+    if (!filter.owner.empty()) {
+      uid_t uid;
+
+      if (!getuserid(filter.owner, &uid) || (ctx.has_uid && uid != ctx.uid)) {
+        return;
+      }
+
+      ctx.has_uid = true;
+      ctx.uid = uid;
+    }
+
+    if (sysinfo(&ctx.sys_info) != 0) {
+      throw new std::logic_error("`sysinfo` return non-zero code");
+    }
+
+    ctx.boottime = custom ? read_boottime(ctx.procfd) : boottime(ctx.procfd);
+
+    std::vector<uint32_t> listed;
+
+    // requested pids are opened directly without reading `/proc`
+    if (!ctx.direct) {
+      probe measure(options.stats, PHASE_LIST);
+      listed = ls(ctx.procfd);
+    }
+
+    const std::vector<uint32_t> &pids = ctx.direct ? filter.pids : listed;
+
+    for (size_t begin = 0; begin < pids.size(); begin += batch_size) {
+      size_t count = std::min(batch_size, pids.size() - begin);
+      list_t batch = scan_entries(&pids[begin], count, ctx,
+        options.concurrency, options.stats);
+
+      if (!batch.empty() && !handler(&batch)) {
+        return;
+      }
+    }
+  }
 }  // namespace pl
@@ -0,0 +1,401 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "unix/watcher.h"  // NOLINT(build/include)
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "filter.h"  // NOLINT(build/include)
+
+/**
+ * fields which don't change until exec or uid change
+ */
+static struct pl::process_fields static_fields() {
+  struct pl::process_fields fields = {};
+  fields.pid = true;
+  fields.name = true;
+  fields.path = true;
+  fields.owner = true;
+  fields.uid = true;
+  fields.cmdline = true;
+  fields.starttime = true;
+
+  return fields;
+}
+
+/**
+ * convert kernel event, return false for events of threads
+ * and the ones not tracked
+ */
+static bool decode(const struct proc_event *ev, pl::process_event *event) {
+  switch (ev->what) {
+    case proc_event::PROC_EVENT_FORK:
+      if (ev->event_data.fork.child_pid != ev->event_data.fork.child_tgid) {
+        return false;
+      }
+
+      event->type = pl::EVENT_FORK;
+      event->pid = ev->event_data.fork.child_tgid;
+      event->value = ev->event_data.fork.parent_tgid;
+      return true;
+    case proc_event::PROC_EVENT_EXEC:
+      event->type = pl::EVENT_EXEC;
+      event->pid = ev->event_data.exec.process_tgid;
+      event->value = 0;
+      return true;
+    case proc_event::PROC_EVENT_EXIT:
+      if (ev->event_data.exit.process_pid !=
+          ev->event_data.exit.process_tgid) {
+        return false;
+      }
+
+      event->type = pl::EVENT_EXIT;
+      event->pid = ev->event_data.exit.process_tgid;
+      event->value = ev->event_data.exit.exit_code;
+      return true;
+    case proc_event::PROC_EVENT_UID:
+      if (ev->event_data.id.process_pid != ev->event_data.id.process_tgid) {
+        return false;
+      }
+
+      event->type = pl::EVENT_UID;
+      event->pid = ev->event_data.id.process_tgid;
+      event->value = ev->event_data.id.e.euid;
+      return true;
+    default:
+      return false;
+  }
+}
+
+namespace pl {
+
+watcher::watcher() : sock(-1), wakeup(-1), seeded(false), stopped(false) {
+  sock = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+
+  if (sock == -1) {
+    throw std::runtime_error("can't open netlink socket");
+  }
+
+  struct sockaddr_nl addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = CN_IDX_PROC;
+
+  wakeup = eventfd(0, EFD_CLOEXEC);
+
+  if (wakeup == -1 ||
+      bind(sock, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) ||
+      !subscribe(true)) {
+    int error = errno;
+
+    close(sock);
+
+    if (wakeup != -1) {
+      close(wakeup);
+    }
+
+    throw std::runtime_error(std::string("can't subscribe to process events: ")
+      + strerror(error));
+  }
+}
+
+watcher::~watcher() {
+  stop();
+  subscribe(false);
+
+  close(sock);
+  close(wakeup);
+}
+
+bool watcher::subscribe(bool listen) {
+  enum proc_cn_mcast_op op = listen ? PROC_CN_MCAST_LISTEN :
+    PROC_CN_MCAST_IGNORE;
+
+  static const size_t kSize = NLMSG_SPACE(sizeof(struct cn_msg) +
+    sizeof(enum proc_cn_mcast_op));
+
+  alignas(struct nlmsghdr) char buf[kSize];
+  memset(buf, 0, sizeof(buf));
+
+  struct nlmsghdr *hdr = reinterpret_cast<struct nlmsghdr *>(buf);
+  hdr->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(op));
+  hdr->nlmsg_type = NLMSG_DONE;
+
+  struct cn_msg *msg = reinterpret_cast<struct cn_msg *>(NLMSG_DATA(hdr));
+  msg->id.idx = CN_IDX_PROC;
+  msg->id.val = CN_VAL_PROC;
+  msg->len = sizeof(op);
+  memcpy(msg->data, &op, sizeof(op));
+
+  return send(sock, buf, hdr->nlmsg_len, 0) != -1;
+}
+
+void watcher::start(const event_handler &on_event,
+                    const error_handler &on_error) {
+  this->on_event = on_event;
+  this->on_error = on_error;
+
+  thread = std::thread(&watcher::run, this);
+}
+
+void watcher::stop() {
+  if (thread.joinable()) {
+    uint64_t one = 1;
+    write(wakeup, &one, sizeof(one));
+
+    thread.join();
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  stopped = true;
+  seeded_cond.notify_all();
+}
+
+void watcher::seed() {
+  list_t list = pl::list(static_fields(), list_options());
+
+  std::lock_guard<std::mutex> guard(lock);
+  table.clear();
+
+  for (auto &proc : list) {
+    own_strings(&proc);
+    table.emplace_hint(table.end(), proc.pid, std::move(proc));
+  }
+
+  seeded = true;
+  seed_error.clear();
+  seeded_cond.notify_all();
+}
+
+void watcher::reread(uint32_t pid) {
+  list_options options;
+  options.filter.pids.push_back(pid);
+
+  list_t list;
+
+  try {
+    list = pl::list(static_fields(), options);
+  } catch(const std::exception &) {
+    // the process is already gone
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+
+  if (list.empty()) {
+    table.erase(pid);
+  } else {
+    own_strings(&list[0]);
+    table[pid] = std::move(list[0]);
+  }
+}
+
+void watcher::handle(const process_event &event) {
+  if (event.type == EVENT_EXIT) {
+    std::lock_guard<std::mutex> guard(lock);
+    table.erase(event.pid);
+  } else {
+    reread(event.pid);
+  }
+
+  on_event(event);
+}
+
+void watcher::run() {
+  try {
+    seed();
+  } catch(const std::exception &e) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      seed_error = e.what();
+      seeded_cond.notify_all();
+    }
+
+    on_error(e.what());
+  }
+
+  struct pollfd fds[2];
+  fds[0].fd = sock;
+  fds[0].events = POLLIN;
+  fds[1].fd = wakeup;
+  fds[1].events = POLLIN;
+
+  alignas(struct nlmsghdr) char buf[8192];
+
+  while (true) {
+    if (poll(fds, 2, -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      on_error("can't poll netlink socket");
+      break;
+    }
+
+    if (fds[1].revents & POLLIN) {
+      break;
+    }
+
+    struct sockaddr_nl from;
+    socklen_t fromlen = sizeof(from);
+
+    ssize_t len = recvfrom(sock, buf, sizeof(buf), MSG_DONTWAIT,
+      reinterpret_cast<struct sockaddr *>(&from), &fromlen);
+
+    if (len == -1) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+
+      // the socket buffer overflowed, so read the whole table again
+      if (errno == ENOBUFS) {
+        try {
+          seed();
+        } catch(const std::exception &e) {
+          on_error(e.what());
+        }
+
+        continue;
+      }
+
+      on_error(std::string("can't read process events: ") + strerror(errno));
+      break;
+    }
+
+    // only the kernel sends process events
+    if (from.nl_pid != 0) {
+      continue;
+    }
+
+    for (struct nlmsghdr *hdr = reinterpret_cast<struct nlmsghdr *>(buf);
+         NLMSG_OK(hdr, len);
+         hdr = NLMSG_NEXT(hdr, len)) {
+      if (hdr->nlmsg_type == NLMSG_ERROR || hdr->nlmsg_type == NLMSG_NOOP) {
+        continue;
+      }
+
+      auto *msg = reinterpret_cast<struct cn_msg *>(NLMSG_DATA(hdr));
+
+      if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC) {
+        continue;
+      }
+
+      process_event event;
+
+      if (decode(reinterpret_cast<struct proc_event *>(msg->data), &event)) {
+        handle(event);
+      }
+    }
+  }
+}
+
+list_t watcher::snapshot(const struct process_fields &fields,
+                         const struct list_options &options) {
+  list_options dynamic_options = options;
+  std::vector<uint32_t> &pids = dynamic_options.filter.pids;
+
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    seeded_cond.wait(guard, [this]() {
+      return seeded || stopped || !seed_error.empty();
+    });
+
+    if (!seeded && !seed_error.empty()) {
+      throw std::runtime_error("process table isn't read: " + seed_error);
+    }
+
+    if (!seeded) {
+      throw std::runtime_error("process table isn't read");
+    }
+
+    std::vector<uint32_t> known;
+    known.reserve(table.size());
+
+    for (const auto &entry : table) {
+      if (match_pid(options.filter, entry.first)) {
+        known.push_back(entry.first);
+      }
+    }
+
+    pids.swap(known);
+  }
+
+  // empty pid filter means any process
+  if (pids.empty()) {
+    return list_t();
+  }
+
+  // the start time tells the known process from a new one with its pid
+  struct process_fields dynamic = fields;
+  dynamic.pid = dynamic.starttime = true;
+  dynamic.name = dynamic.path = dynamic.owner = dynamic.uid = false;
+  dynamic.cmdline = false;
+
+  // known pids are read directly, so `/proc` isn't walked
+  list_t list = pl::list(dynamic, dynamic_options);
+
+  std::lock_guard<std::mutex> guard(lock);
+  size_t size = 0;
+
+  for (size_t i = 0; i < list.size(); ++i) {
+    auto entry = table.find(list[i].pid);
+
+    // exited and the pid is reused by the process not handled yet,
+    // it's added to the table by its fork event
+    if (entry == table.end() ||
+        entry->second.starttime != list[i].starttime) {
+      continue;
+    }
+
+    if (size != i) {
+      list[size] = std::move(list[i]);
+    }
+
+    process &proc = list[size++];
+    const process &known = entry->second;
+
+    // dynamic fields have no strings, all of them are kept by the table
+    proc.strings = known.strings;
+
+    if (fields.name) {
+      proc.name = known.name;
+    }
+
+    if (fields.path) {
+      proc.path = known.path;
+    }
+
+    if (fields.owner) {
+      proc.owner = known.owner;
+    }
+
+    if (fields.uid) {
+      proc.uid = known.uid;
+    }
+
+    if (fields.cmdline) {
+      proc.cmdline = known.cmdline;
+    }
+  }
+
+  list.resize(size);
+  return list;
+}
+
+}  // namespace pl
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_UNIX_WATCHER_H_
+#define SRC_UNIX_WATCHER_H_
+
+#include <stdint.h>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <functional>
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "tasklist.h"  // NOLINT(build/include)
+
+namespace pl {
+
+enum event_type {
+  EVENT_FORK,
+  EVENT_EXEC,
+  EVENT_EXIT,
+  EVENT_UID
+};
+
+struct process_event {
+  event_type type;
+  uint32_t pid;
+
+  // parent pid of fork, wait status of exit, effective uid of uid change
+  uint32_t value;
+};
+
+typedef std::function<void(const process_event &)> event_handler;
+typedef std::function<void(const std::string &)> error_handler;
+
+/**
+ * keeps the process table up to date with events of the netlink
+ * proc connector, so `/proc` is walked only once.
+ * Requires CAP_NET_ADMIN.
+ */
+class watcher {
+ public:
+  /**
+   * subscribe to events, throws if the connector isn't available
+   */
+  watcher();
+  ~watcher();
+
+  /**
+   * read the table and handle events on the own thread,
+   * handlers are called on that thread
+   */
+  void start(const event_handler &on_event, const error_handler &on_error);
+  void stop();
+
+  /**
+   * read process list from the table,
+   * only changing fields like memory and cpu are read from `/proc`
+   */
+  list_t snapshot(const struct process_fields &, const struct list_options &);
+
+ private:
+  void run();
+  void seed();
+  void handle(const process_event &event);
+  void reread(uint32_t pid);
+  bool subscribe(bool listen);
+
+  int sock;
+  int wakeup;
+  std::thread thread;
+
+  event_handler on_event;
+  error_handler on_error;
+
+  std::mutex lock;
+  std::condition_variable seeded_cond;
+  bool seeded;
+  bool stopped;
+
+  // why the table isn't read, snapshots fail with it instead of waiting
+  std::string seed_error;
+
+  // static fields of every process by pid
+  std::map<uint32_t, process> table;
+};
+
+}  // namespace pl
+
+#endif  // SRC_UNIX_WATCHER_H_
@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#include "unix/watcher_wrap.h"  // NOLINT(build/include)
+
+#include <nan.h>
+
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "snapshot.h"  // NOLINT(build/include)
+
+using v8::FunctionTemplate;
+using v8::Function;
+using v8::Object;
+using v8::Local;
+using v8::Value;
+using pl::process_fields;
+using pl::list_options;
+
+#define STR(s) Nan::New<v8::String>(s).ToLocalChecked()
+
+static const char *event_names[] = {
+  "fork",
+  "exec",
+  "exit",
+  "uid"
+};
+
+class WatchSnapshotWorker : public SnapshotWorker {
+ public:
+  WatchSnapshotWorker(Nan::Callback *callback,
+                      const struct process_fields &fields,
+                      const struct list_options &options,
+                      const struct output_options &output,
+                      pl::watcher *watcher)
+  : SnapshotWorker(callback, fields, options, output), watcher(watcher) {
+  }
+
+ protected:
+  pl::list_t Collect() {
+    return watcher->snapshot(psfields, psoptions);
+  }
+
+ private:
+  pl::watcher *watcher;
+};
+
+static void close_async(uv_handle_t *handle) {
+  delete reinterpret_cast<uv_async_t *>(handle);
+}
+
+Watcher::Watcher(Nan::Callback *callback)
+: callback(callback), closed(false) {
+  async_resource = new Nan::AsyncResource("pl:Watcher");
+
+  async = new uv_async_t;
+  uv_async_init(Nan::GetCurrentEventLoop(), async, Deliver);
+  async->data = this;
+
+  watcher.start(
+    [this](const pl::process_event &event) {
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        events.push_back(event);
+      }
+
+      uv_async_send(async);
+    },
+    [this](const std::string &error) {
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        errors.push_back(error);
+      }
+
+      uv_async_send(async);
+    });
+}
+
+Watcher::~Watcher() {
+  delete callback;
+  delete async_resource;
+}
+
+void Watcher::Deliver(uv_async_t *handle) {
+  Watcher *obj = static_cast<Watcher *>(handle->data);
+
+  std::vector<pl::process_event> events;
+  std::vector<std::string> errors;
+
+  {
+    std::lock_guard<std::mutex> guard(obj->lock);
+    events.swap(obj->events);
+    errors.swap(obj->errors);
+  }
+
+  Nan::HandleScope scope;
+
+  for (const auto &error : errors) {
+    Local<Value> argv[] = {
+      STR("error"),
+      STR(error)
+    };
+
+    obj->callback->Call(2, argv, obj->async_resource);
+  }
+
+  for (const auto &event : events) {
+    Local<Value> argv[] = {
+      STR(event_names[event.type]),
+      Nan::New<v8::Number>(event.pid),
+      Nan::New<v8::Number>(event.value)
+    };
+
+    obj->callback->Call(3, argv, obj->async_resource);
+  }
+}
+
+NAN_MODULE_INIT(Watcher::Init) {
+  Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+  tpl->SetClassName(Nan::New("Watcher").ToLocalChecked());
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::SetPrototypeMethod(tpl, "snapshot", Snapshot);
+  Nan::SetPrototypeMethod(tpl, "close", Close);
+  Nan::SetPrototypeMethod(tpl, "unref", UnrefLoop);
+
+  Nan::Set(target, Nan::New("Watcher").ToLocalChecked(),
+    Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+/**
+ * new Watcher(onEvent)
+ */
+NAN_METHOD(Watcher::New) {
+  if (!info.IsConstructCall()) {
+    return Nan::ThrowTypeError("Class constructor Watcher cannot be invoked "
+      "without 'new'");
+  }
+
+  Watcher *obj;
+
+  try {
+    obj = new Watcher(new Nan::Callback(info[0].As<Function>()));
+  } catch(const std::exception &e) {
+    return Nan::ThrowError(e.what());
+  }
+
+  obj->Wrap(info.This());
+
+  // events are delivered until `close()`
+  obj->Ref();
+
+  info.GetReturnValue().Set(info.This());
+}
+
+NAN_METHOD(Watcher::Snapshot) {
+  Watcher *obj = Nan::ObjectWrap::Unwrap<Watcher>(info.Holder());
+
+  auto fields = process_fields_from(info[0].As<Object>());
+  auto options = list_options_from(info[1].As<Object>());
+  auto output = output_options_from(info[1].As<Object>());
+  auto *callback = new Nan::Callback(info[2].As<Function>());
+
+  auto *worker = new WatchSnapshotWorker(callback, fields, options, output,
+    &obj->watcher);
+
+  // keep the watcher alive until the worker is done
+  worker->SaveToPersistent("watcher", info.Holder());
+
+  queue_worker(worker, info[1].As<Object>());
+}
+
+/**
+ * stop the watcher thread, the table isn't updated anymore
+ */
+NAN_METHOD(Watcher::Close) {
+  Watcher *obj = Nan::ObjectWrap::Unwrap<Watcher>(info.Holder());
+
+  if (obj->closed) {
+    return;
+  }
+
+  obj->closed = true;
+  obj->watcher.stop();
+
+  uv_close(reinterpret_cast<uv_handle_t *>(obj->async), close_async);
+  obj->Unref();
+}
+
+/**
+ * don't keep the event loop alive
+ */
+NAN_METHOD(Watcher::UnrefLoop) {
+  Watcher *obj = Nan::ObjectWrap::Unwrap<Watcher>(info.Holder());
+
+  if (!obj->closed) {
+    uv_unref(reinterpret_cast<uv_handle_t *>(obj->async));
+  }
+}
@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2014 Dmitry Tsvettsikh <https://github.com/reklatsmasters>
+ *
+ * MIT License <https://github.com/reklatsmasters/node-process-list/blob/master/LICENSE>
+ */
+
+#ifndef SRC_UNIX_WATCHER_WRAP_H_
+#define SRC_UNIX_WATCHER_WRAP_H_
+
+#include <nan.h>
+
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "unix/watcher.h"  // NOLINT(build/include)
+
+/**
+ * js binding of `pl::watcher`, events are passed
+ * from the watcher thread to the event loop
+ */
+class Watcher : public Nan::ObjectWrap {
+ public:
+  static NAN_MODULE_INIT(Init);
+
+ private:
+  explicit Watcher(Nan::Callback *callback);
+  ~Watcher();
+
+  static NAN_METHOD(New);
+  static NAN_METHOD(Snapshot);
+  static NAN_METHOD(Close);
+  static NAN_METHOD(UnrefLoop);
+
+  /**
+   * pass queued events to js, it's called on the event loop
+   */
+  static void Deliver(uv_async_t *handle);
+
+  pl::watcher watcher;
+  Nan::Callback *callback;
+  Nan::AsyncResource *async_resource;
+  uv_async_t *async;
+  bool closed;
+
+  std::mutex lock;
+  std::vector<pl::process_event> events;
+  std::vector<std::string> errors;
+};
+
+#endif  // SRC_UNIX_WATCHER_WRAP_H_
@@ -16,10 +16,16 @@
 #include <tchar.h>
 #include <atlbase.h>
 
+#include <algorithm>
 #include <codecvt>
+#include <memory>
 #include <string>
 #include <iostream>
 #include <ctime>
+#include <limits>
+#include <utility>
+
+#include "filter.h"  // NOLINT(build/include)
 
 using pl::process;
 
@@ -372,7 +378,27 @@ namespace pl {
   /**
    * main function
    */
-  list_t list(const struct process_fields &requested_fields) {
+  list_t list(const struct process_fields &requested_fields,
+              const struct list_options &options) {
+    list_t proclist;
+
+    list(requested_fields, options, std::numeric_limits<size_t>::max(),
+      [&proclist](list_t *batch) {
+        proclist.swap(*batch);
+        return true;
+      });
+
+    return proclist;
+  }
+
+  /**
+   * WMI enumerator is sequential, so `options.concurrency` is ignored.
+   * WMI returns whole rows, so the filter is checked after the row is read
+   */
+  void list(const struct process_fields &requested_fields,
+            const struct list_options &options,
+            size_t batch_size,
+            const batch_handler &handler) {
     // Initialize COM.
     CoInitializeHelper co;
 
@@ -380,7 +406,15 @@ namespace pl {
       throw std::logic_error("Failed to initialize COM library");
     }
 
+    const struct process_filter &filter = options.filter;
     list_t proclist;
+    proclist.reserve(std::min<size_t>(batch_size, 1024));
+
+    // strings of the current batch
+    auto strings = std::make_shared<string_arena>();
+    auto interned = std::unique_ptr<string_interner>(
+      new string_interner(strings.get()));
+
     LONG flagsOpen = WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY;
 
     struct WMI *wmi = wmiopen("SELECT * FROM Win32_Process", flagsOpen);
@@ -395,24 +429,27 @@ namespace pl {
         break;
       }
 
-      if (requested_fields.pid) {
+      if (requested_fields.pid || !filter.pids.empty()) {
         proc.pid = wmiprop<uint32_t>(&entry, L"ProcessId", 0);
       }
 
-      if (requested_fields.ppid) {
+      if (requested_fields.ppid || filter.has_ppid) {
         proc.ppid = wmiprop<uint32_t>(&entry, L"ParentProcessId", 0);
       }
 
-      if (requested_fields.name) {
-        proc.name = wmiprop<std::string>(&entry, L"Name", "");
+      if (requested_fields.name || !filter.name.empty()) {
+        proc.name = interned->intern(
+          wmiprop<std::string>(&entry, L"Name", ""));
       }
 
       if (requested_fields.path) {
-        proc.path = wmiprop<std::string>(&entry, L"ExecutablePath", "");
+        proc.path = interned->intern(
+          wmiprop<std::string>(&entry, L"ExecutablePath", ""));
       }
 
       if (requested_fields.cmdline) {
-        proc.cmdline = wmiprop<std::string>(&entry, L"CommandLine", "");
+        proc.cmdline = strings->store(
+          wmiprop<std::string>(&entry, L"CommandLine", ""));
       }
 
       if (requested_fields.threads) {
@@ -423,13 +460,13 @@ namespace pl {
         proc.priority = wmiprop<uint32_t>(&entry, L"Priority", 0);
       }
 
-      if (requested_fields.owner) {
-        proc.owner = wmicall<std::string>(
+      if (requested_fields.owner || !filter.owner.empty()) {
+        proc.owner = interned->intern(wmicall<std::string>(
           wmi,
           &entry,
           L"GetOwner",
           L"User",
-          std::string());
+          std::string()));
       }
 
       if (requested_fields.starttime) {
@@ -469,10 +506,46 @@ namespace pl {
         proc.stime = TO_MS(proc.stime);
       }
 
-      proclist.push_back(proc);
+      if (requested_fields.rchar) {
+        proc.rchar = _wtoi64(wmiprop<BSTR>(&entry, L"ReadTransferCount", 0));
+      }
+
+      if (requested_fields.wchar) {
+        proc.wchar = _wtoi64(wmiprop<BSTR>(&entry, L"WriteTransferCount", 0));
+      }
+
+      if (requested_fields.syscr) {
+        proc.syscr = _wtoi64(wmiprop<BSTR>(&entry, L"ReadOperationCount", 0));
+      }
+
+      if (requested_fields.syscw) {
+        proc.syscw = _wtoi64(wmiprop<BSTR>(&entry, L"WriteOperationCount", 0));
+      }
+
+      if (!match(filter, proc)) {
+        continue;
+      }
+
+      proc.strings = strings;
+      proclist.push_back(std::move(proc));
+
+      if (proclist.size() == batch_size) {
+        bool next = handler(&proclist);
+        proclist.clear();
+
+        if (!next) {
+          break;
+        }
+
+        strings = std::make_shared<string_arena>();
+        interned.reset(new string_interner(strings.get()));
+      }
+    }
+
+    if (!proclist.empty()) {
+      handler(&proclist);
     }
 
     wmiclose(wmi);
-    return proclist;
   }
 }  // namespace pl
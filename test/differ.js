@@ -0,0 +1,89 @@
+'use strict'
+
+import test from 'ava'
+import fs from 'fs'
+import os from 'os'
+import path from 'path'
+import ps from '../'
+
+test('first diff adds everything', async t => {
+  const differ = new ps.Differ()
+  const diff = await differ.diff('pid', 'pmem')
+
+  t.not(diff.added.length, 0)
+  t.is(diff.removed.length, 0)
+  t.is(diff.changed.length, 0)
+  t.deepEqual(Object.keys(diff.added[0]), ['pid', 'starttime', 'pmem'])
+})
+
+test('spawned and exited processes', async t => {
+  const differ = new ps.Differ({ pmem: Number.MAX_SAFE_INTEGER })
+  await differ.diff('pid', 'pmem')
+
+  const child = require('child_process').spawn('sleep', ['10'])
+  const spawned = await differ.diff('pid', 'pmem')
+
+  t.true(spawned.added.some(task => task.pid === child.pid))
+  t.is(spawned.changed.length, 0)
+
+  child.kill()
+  await new Promise(resolve => child.on('exit', resolve))
+
+  const exited = await differ.diff('pid', 'pmem')
+  t.true(exited.removed.some(task => task.pid === child.pid))
+})
+
+test('diff stats', async t => {
+  const before = ps.getStats().snapshots
+  const diff = await new ps.Differ().diff('pid', { stats: true })
+
+  t.true(diff.stats.processes > 0)
+  t.true(diff.stats.phases.scan.wall > 0)
+  t.true(diff.stats.phases.convert.wall > 0)
+  t.true(ps.getStats().snapshots > before)
+  t.deepEqual(Object.keys(diff), ['added', 'removed', 'changed'])
+})
+
+test('unknown threshold', t => {
+  t.throws(() => new ps.Differ({ name: 1 }))
+})
+
+test('kept processes do not hold old snapshots', async t => {
+  if (process.platform !== 'linux') {
+    return t.pass()
+  }
+
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'procfs-'))
+  const cmdline = 'x'.repeat(4000)
+
+  const spawn = pid => {
+    const dir = path.join(root, String(pid))
+
+    fs.mkdirSync(dir)
+    fs.writeFileSync(path.join(dir, 'stat'), `${pid} (fake) S 1 ${pid} ${pid} 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 100 0 0`)
+    fs.writeFileSync(path.join(dir, 'cmdline'), `${cmdline}${pid}\0`)
+  }
+
+  fs.writeFileSync(path.join(root, 'stat'), 'cpu  1 0 1 1\nbtime 1600000000\n')
+
+  for (let pid = 1; pid <= 1000; ++pid) {
+    spawn(pid)
+  }
+
+  const differ = new ps.Differ()
+  const diff = () => differ.diff('pid', 'cmdline', { procfs: root })
+
+  t.is((await diff()).added.length, 1000)
+  const rss = process.memoryUsage().rss
+
+  // every diff adds one process, the snapshot it's read by is 4 MiB
+  for (let pid = 1001; pid <= 1030; ++pid) {
+    spawn(pid)
+    const { added } = await diff()
+
+    t.is(added.length, 1)
+    t.true(added[0].cmdline === cmdline + pid)
+  }
+
+  t.true(process.memoryUsage().rss - rss < 32 * 1024 * 1024)
+})
@@ -0,0 +1,161 @@
+'use strict'
+
+import test from 'ava'
+import ps from '../'
+
+test('interval cpu usage', async t => {
+  const sampler = new ps.Sampler()
+
+  await sampler.sample('pid', 'cpu')
+
+  const tasks = await sampler.sample('pid', 'cpu')
+
+  t.true(Array.isArray(tasks))
+  t.not(tasks.length, 0)
+  t.deepEqual(Object.keys(tasks[0]), ['pid', 'cpu'])
+
+  for (const task of tasks) {
+    t.true(task.cpu >= 0 && task.cpu <= 100)
+  }
+})
+
+test('busy process', async t => {
+  const sampler = new ps.Sampler()
+
+  await sampler.sample('pid', 'cpu')
+
+  const start = Date.now()
+  while (Date.now() - start < 300) {}
+
+  const tasks = await sampler.sample('pid', 'cpu')
+  const self = tasks.find(task => task.pid === process.pid)
+
+  t.true(self.cpu > 0)
+})
+
+test('io rates', async t => {
+  const sampler = new ps.Sampler()
+  const options = { numeric: 'number', filter: { pids: [process.pid] } }
+
+  await sampler.sample('pid', 'rchar', 'syscr', options)
+  await new Promise(resolve => setTimeout(resolve, 100))
+
+  const tasks = await sampler.sample('pid', 'rchar', 'syscr', options)
+
+  t.deepEqual(Object.keys(tasks[0]), ['pid', 'rchar', 'syscr'])
+  t.true(tasks[0].rchar >= 0)
+  t.true(tasks[0].syscr >= 0)
+})
+
+test('background sampling', async t => {
+  const sampler = new ps.Sampler()
+
+  t.is(sampler.getLatest(), null)
+  t.throws(() => sampler.start('pid', { interval: 0 }))
+
+  sampler.start('pid', 'cpu', { interval: 20, filter: { pids: [process.pid] } })
+
+  let tasks = null
+
+  for (let i = 0; i < 100 && tasks === null; ++i) {
+    await new Promise(resolve => setTimeout(resolve, 10))
+    tasks = sampler.getLatest()
+  }
+
+  t.deepEqual(Object.keys(tasks[0]), ['pid', 'cpu'])
+  t.is(tasks[0].pid, process.pid)
+  t.not(sampler.getLatest(), tasks)
+
+  sampler.start('pid', { columnar: true, interval: 20 })
+  await new Promise(resolve => setTimeout(resolve, 200))
+
+  const columns = sampler.getLatest()
+  t.true(columns.pid instanceof Uint32Array)
+  t.not(columns.length, 0)
+
+  sampler.stop()
+  sampler.stop()
+})
+
+test('background sampling with sample()', async t => {
+  // busy for 300 ms, then idle
+  const child = require('child_process').spawn(process.execPath, ['-e',
+    'const end = Date.now() + 300; while (Date.now() < end); setTimeout(() => {}, 10000)'])
+  const sampler = new ps.Sampler()
+
+  await new Promise(resolve => setTimeout(resolve, 600))
+  sampler.start('pid', 'cpu', { interval: 50, filter: { pids: [child.pid] } })
+
+  // `sample()` of another process doesn't drop the baseline of the child
+  for (let i = 0; i < 40; ++i) {
+    const own = await sampler.sample('pid', 'cpu', { filter: { pids: [process.pid] } })
+    t.is(own[0].pid, process.pid)
+
+    await new Promise(resolve => setTimeout(resolve, 10))
+  }
+
+  const [idle] = sampler.getLatest()
+  sampler.stop()
+  child.kill()
+  await new Promise(resolve => child.once('exit', resolve))
+
+  t.is(idle.pid, child.pid)
+  t.is(idle.cpu, 0)
+})
+
+test('shared table', async t => {
+  const { Worker } = require('worker_threads')
+  const sampler = new ps.Sampler()
+  const buffer = sampler.share({ capacity: 4, heapSize: 64 })
+  const table = new ps.SharedTable(buffer)
+
+  t.is(table.generation, 0)
+  t.throws(() => sampler.share({ capacity: 0 }))
+
+  sampler.start('pid', 'name', 'pmem', 'cmdline', { interval: 20 })
+
+  while (table.generation === 0) {
+    await new Promise(resolve => setTimeout(resolve, 10))
+  }
+
+  const tasks = table.snapshot()
+
+  t.is(tasks.length, 4)
+  t.deepEqual(Object.keys(tasks[0]), ['name', 'pid', 'cmdline', 'pmem'])
+  t.true(tasks[0].pid > 0)
+  t.true(table.read(view => view.truncated))
+
+  const worker = new Worker(`
+    const { parentPort, workerData } = require('worker_threads')
+    const { SharedTable } = require(workerData.module)
+    const table = new SharedTable(workerData.buffer)
+    parentPort.postMessage(table.read(view => Array.from(view.pid)))
+  `, { eval: true, workerData: { buffer, module: require.resolve('../shared') } })
+
+  const pids = await new Promise((resolve, reject) => {
+    worker.once('message', resolve)
+    worker.once('error', reject)
+  })
+
+  t.is(pids.length, 4)
+  sampler.stop()
+})
+
+test('shared table with a stuck writer', t => {
+  const sampler = new ps.Sampler()
+  const buffer = sampler.share({ capacity: 4, heapSize: 64 })
+  const table = new ps.SharedTable(buffer)
+  const header = new Uint32Array(buffer, 0, 16)
+
+  // a writer died in the middle of publishing
+  Atomics.add(header, 2, 1)
+
+  const start = Date.now()
+  const err = t.throws(() => table.read(view => view.length))
+
+  t.regex(err.message, /isn't consistent/)
+  t.true(Date.now() - start < 5000)
+
+  Atomics.add(header, 2, 1)
+  t.is(table.read(view => view.length), 0)
+})
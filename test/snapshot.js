@@ -1,5 +1,8 @@
 'use strict'
 
+import fs from 'fs'
+import os from 'os'
+import path from 'path'
 import test from 'ava'
 import ps from '../'
 
@@ -8,7 +11,11 @@ test('default', async t => {
 
   t.true(Array.isArray(tasks))
   t.not(tasks.length, 0)
-  t.deepEqual(Object.keys(tasks[0]), ps.allowedFields)
+  t.deepEqual(Object.keys(tasks[0]), [
+    'name', 'pid', 'ppid', 'path', 'threads', 'owner', 'priority', 'cmdline',
+    'starttime', 'vmem', 'pmem', 'cpu', 'utime', 'stime'
+  ])
+  t.deepEqual(ps.defaultFields, Object.keys(tasks[0]))
 })
 
 test('one field', async t => {
@@ -36,3 +43,387 @@ test('check every field one-by-one', async t => {
     t.deepEqual(Object.keys(tasks[0]), [field])
   }
 })
+
+test('parallel scan keeps pid order', async t => {
+  const tasks = await ps.snapshot('pid', 'ppid', 'cmdline', { concurrency: 4 })
+  const pids = tasks.map(task => task.pid)
+
+  t.true(Array.isArray(tasks))
+  t.not(tasks.length, 0)
+  t.deepEqual(Object.keys(tasks[0]), ['pid', 'ppid', 'cmdline'])
+  t.deepEqual(pids, pids.slice().sort((a, b) => a - b))
+})
+
+test('strings of parallel readers', async t => {
+  const fields = ['pid', 'starttime', 'name', 'path', 'owner']
+  const [sequential, parallel] = await Promise.all([
+    ps.snapshot(...fields),
+    ps.snapshot(...fields, { concurrency: 4 })
+  ])
+  const known = new Map(sequential.map(task => [task.pid, task]))
+  let compared = 0
+
+  for (const task of parallel) {
+    const other = known.get(task.pid)
+
+    if (other && other.starttime.getTime() === task.starttime.getTime()) {
+      t.deepEqual(task, other)
+      ++compared
+    }
+  }
+
+  t.true(compared > 0)
+})
+
+test('name with and without path', async t => {
+  const names = await ps.snapshot('pid', 'name')
+  const withPath = await ps.snapshot('pid', 'name', 'path')
+  const byPid = new Map(withPath.map(task => [task.pid, task.name]))
+
+  for (const task of names) {
+    if (byPid.has(task.pid)) {
+      t.is(byPid.get(task.pid), task.name)
+    }
+  }
+
+  t.true(names.some(task => task.pid === process.pid))
+})
+
+test('invalid concurrency', t => {
+  t.throws(() => ps.snapshot('pid', { concurrency: 0 }))
+})
+
+test('owner cache', async t => {
+  const cached = await ps.snapshot('pid', 'owner', 'uid')
+  const uncached = await ps.snapshot('pid', 'owner', 'uid', { ownerCacheTtl: 0 })
+  const self = uncached.find(task => task.pid === process.pid)
+
+  t.is(self.uid, process.getuid())
+  t.is(
+    cached.find(task => task.pid === process.pid).owner,
+    self.owner
+  )
+})
+
+test('columnar', async t => {
+  const tasks = await ps.snapshot('pid', 'name', 'cpu', 'pmem', { columnar: true })
+
+  t.not(tasks.length, 0)
+  t.deepEqual(Object.keys(tasks), ['length', 'name', 'pid', 'pmem', 'cpu'])
+  t.true(tasks.pid instanceof Uint32Array)
+  t.true(tasks.cpu instanceof Float64Array)
+  t.is(tasks.pid.length, tasks.length)
+  t.is(tasks.name.offsets.length, tasks.length + 1)
+
+  const objects = await ps.snapshot('pid', 'name')
+  const self = objects.find(task => task.pid === process.pid)
+  const index = tasks.pid.indexOf(process.pid)
+
+  t.is(ps.columnString(tasks.name, index), self.name)
+})
+
+test('numeric fields', async t => {
+  const fields = ['vmem', 'pmem', 'utime', 'stime']
+
+  const strings = await ps.snapshot(fields)
+  const numbers = await ps.snapshot(fields, { numeric: 'number' })
+  const bigints = await ps.snapshot(fields, { numeric: 'bigint' })
+
+  for (const field of fields) {
+    t.is(typeof strings[0][field], 'string')
+    t.is(typeof numbers[0][field], 'number')
+    t.is(typeof bigints[0][field], 'bigint')
+  }
+
+  t.throws(() => ps.snapshot('pid', { numeric: 'float' }))
+})
+
+test('filter', async t => {
+  const self = await ps.snapshot('pid', 'ppid', 'name', {
+    filter: { pids: [process.pid, 0x7fffffff] }
+  })
+
+  t.is(self.length, 1)
+  t.is(self[0].pid, process.pid)
+
+  const children = await ps.snapshot('pid', 'ppid', { filter: { ppid: self[0].ppid } })
+  t.true(children.every(task => task.ppid === self[0].ppid))
+  t.truthy(children.find(task => task.pid === process.pid))
+
+  const named = await ps.snapshot('pid', 'name', {
+    filter: { name: self[0].name.slice(0, 2) + '*', uid: process.getuid() }
+  })
+  t.truthy(named.find(task => task.pid === process.pid))
+
+  const none = await ps.snapshot('pid', { filter: { name: 'no such process ?' } })
+  t.is(none.length, 0)
+
+  t.throws(() => ps.snapshot('pid', { filter: { pid: 1 } }))
+  t.throws(() => ps.snapshot('pid', { filter: { ppid: -1 } }))
+  t.throws(() => ps.snapshot('pid', { filter: { ppid: 2 ** 32 } }))
+  t.throws(() => ps.snapshot('pid', { filter: { pids: [] } }))
+  t.throws(() => ps.snapshot('pid', { filter: { pids: [2 ** 32 + process.pid] } }))
+})
+
+test('threads detail', async t => {
+  const tasks = await ps.snapshot('pid', 'threads', { threads: 'detail', filter: { pids: [process.pid] } })
+  const self = tasks[0]
+
+  t.is(self.tasks.length, self.threads)
+  t.is(self.tasks[0].tid, process.pid)
+  t.deepEqual(Object.keys(self.tasks[0]), ['tid', 'name', 'state', 'starttime', 'cpu', 'utime', 'stime'])
+  t.is(self.tasks[0].state.length, 1)
+
+  const sampler = new ps.Sampler()
+  await sampler.sample('pid', { threads: 'detail' })
+  const sampled = await sampler.sample('pid', { threads: 'detail', filter: { pids: [process.pid] } })
+
+  t.true(sampled[0].tasks.every(thread => thread.cpu >= 0 && thread.cpu <= 100))
+  t.throws(() => ps.snapshot('pid', { threads: 'all' }))
+  t.throws(() => ps.snapshot('pid', { threads: 'detail', columnar: true }), TypeError)
+})
+
+test('memory from smaps_rollup', async t => {
+  const fields = ['pmem', 'pss', 'uss', 'swap', 'shared']
+  const tasks = await ps.snapshot(['pid', ...fields], { numeric: 'number', filter: { pids: [process.pid] } })
+  const self = tasks[0]
+
+  t.true(self.pss > 0)
+  t.true(self.uss > 0)
+  t.true(self.uss <= self.pss)
+  t.true(self.uss + self.shared <= self.pmem * 1.1)
+  t.true(self.swap >= 0)
+
+  for (const field of fields) {
+    t.truthy(ps.fieldCost[field])
+  }
+
+  t.is(ps.fieldCost.pss.cost, 'high')
+  t.false(ps.defaultFields.includes('pss'))
+})
+
+test('io counters', async t => {
+  const fields = ['readBytes', 'writeBytes', 'rchar', 'wchar', 'syscr', 'syscw']
+  const tasks = await ps.snapshot(['pid', ...fields], { numeric: 'number', filter: { pids: [process.pid] } })
+  const self = tasks[0]
+
+  t.deepEqual(Object.keys(self), ['pid', ...fields])
+  t.true(self.rchar > 0)
+  t.true(self.syscr > 0)
+
+  for (const field of fields) {
+    t.true(self[field] >= 0)
+  }
+})
+
+test('procfs root', async t => {
+  if (process.platform !== 'linux') {
+    return t.pass()
+  }
+
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'procfs-'))
+  fs.writeFileSync(path.join(root, 'stat'), 'cpu  1 0 1 1\nbtime 1600000000\n')
+
+  fs.mkdirSync(path.join(root, 'net'))
+  fs.mkdirSync(path.join(root, '0x1'))
+
+  for (const pid of [42, 1000, 1, 7]) {
+    const dir = path.join(root, String(pid))
+
+    fs.mkdirSync(dir)
+    fs.writeFileSync(path.join(dir, 'stat'), `${pid} (fake ${pid}) S 1 ${pid} ${pid} 0 -1 0 0 0 0 0 250 50 0 0 20 0 3 0 100 0 0`)
+    fs.writeFileSync(path.join(dir, 'statm'), '256 128 0 0 0 0 0')
+    fs.writeFileSync(path.join(dir, 'cmdline'), `/bin/fake\0${pid}\0`)
+  }
+
+  const tasks = await ps.snapshot('pid', 'name', 'threads', 'starttime', 'cmdline', { procfs: root })
+
+  // pids are sorted though a regular directory isn't listed in pid order
+  t.deepEqual(tasks.map(task => task.pid), [1, 7, 42, 1000])
+  t.is(tasks[2].name, 'fake 42')
+  t.is(tasks[2].threads, 3)
+  t.is(tasks[2].cmdline, '/bin/fake 42')
+  t.true(tasks[2].starttime > new Date(1600000000000))
+  t.throws(() => ps.snapshot('pid', { procfs: '' }))
+  await t.throws(ps.snapshot('pid', { procfs: path.join(root, 'none') }))
+})
+
+test('vanished processes', async t => {
+  if (process.platform !== 'linux') {
+    return t.pass()
+  }
+
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'procfs-'))
+  fs.writeFileSync(path.join(root, 'stat'), 'cpu  1 0 1 1\nbtime 1600000000\n')
+
+  // 2 has exited before `stat` is read, 3 before `statm`,
+  // 1 has no optional files like `exe` of kernel threads
+  for (const pid of [1, 2, 3]) {
+    const dir = path.join(root, String(pid))
+    fs.mkdirSync(dir)
+
+    if (pid !== 2) {
+      fs.writeFileSync(path.join(dir, 'stat'), `${pid} (fake) S 0 ${pid} ${pid} 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 100 0 0`)
+    }
+
+    if (pid === 1) {
+      fs.writeFileSync(path.join(dir, 'statm'), '256 128 0 0 0 0 0')
+    }
+  }
+
+  const tasks = await ps.snapshot('pid', 'pmem', 'path', 'rchar', 'pss', { procfs: root, stats: true })
+
+  t.deepEqual(tasks.map(task => task.pid), [1])
+  t.is(tasks[0].path, '')
+  t.is(tasks[0].rchar, '0')
+  t.is(tasks.stats.processes, 3)
+  t.is(tasks.stats.vanished, 2)
+
+  // short-lived children exit while `/proc` is read
+  const churn = require('child_process').spawn('sh', ['-c', 'while :; do /bin/true; done'])
+
+  try {
+    for (let i = 0; i < 20; ++i) {
+      const all = await ps.snapshot('pid', 'cmdline', 'pmem', 'owner', { concurrency: 2 })
+      t.true(all.length > 0)
+    }
+  } finally {
+    churn.kill()
+    await new Promise(resolve => churn.once('exit', resolve))
+  }
+})
+
+
+test('snapshotSync', t => {
+  const tasks = ps.snapshotSync('pid', 'name', 'pmem', { filter: { pids: [process.pid] } })
+
+  t.is(tasks.length, 1)
+  t.is(tasks[0].pid, process.pid)
+  t.deepEqual(Object.keys(tasks[0]), ['name', 'pid', 'pmem'])
+
+  const columns = ps.snapshotSync('pid', { columnar: true })
+  t.not(columns.length, 0)
+  t.true(columns.pid instanceof Uint32Array)
+
+  t.throws(() => ps.snapshotSync('pid', { procfs: '/nonexistent' }))
+})
+
+test('dedicated executor', async t => {
+  const options = { executor: 'dedicated', filter: { pids: [process.pid] } }
+  const results = await Promise.all([
+    ps.snapshot('pid', options),
+    ps.tree('pid', options),
+    new ps.Sampler().sample('pid', 'cpu', options)
+  ])
+
+  for (const tasks of results) {
+    t.is(tasks[0].pid, process.pid)
+  }
+
+  await t.throws(ps.snapshot('pid', { executor: 'dedicated', procfs: '/nonexistent' }))
+  t.throws(() => ps.snapshot('pid', { executor: 'thread' }))
+})
+
+test('stats', async t => {
+  const tasks = await ps.snapshot('pid', 'name', 'cmdline', { stats: true, concurrency: 2 })
+  const { stats } = tasks
+
+  t.false(Object.keys(tasks).includes('stats'))
+  t.is(stats.processes, tasks.length + stats.skipped + stats.vanished)
+  t.true(stats.phases.list.calls === 1)
+  t.true(stats.phases.stat.calls >= tasks.length)
+  t.true(stats.phases.stat.syscalls > 0)
+  t.true(stats.phases.cmdline.bytes > 0)
+  t.true(stats.phases.convert.wall > 0)
+
+  const filtered = ps.snapshotSync('pid', { stats: true, filter: { ppid: process.pid } })
+  t.is(filtered.stats.skipped, filtered.stats.processes - filtered.length)
+
+  t.is((await ps.snapshot('pid')).stats, undefined)
+
+  const cumulative = ps.getStats()
+  t.true(cumulative.snapshots >= 2)
+  t.true(cumulative.phases.scan.calls >= 2)
+  t.is(cumulative.histograms.scan.length, 32)
+  t.true(cumulative.histograms.scan.reduce((a, b) => a + b) >= 2)
+
+  t.throws(() => ps.snapshot('pid', { stats: 1 }))
+})
+
+test.serial('full metadata cache keeps live processes', async t => {
+  if (process.platform !== 'linux') {
+    return t.pass()
+  }
+
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'procfs-'))
+
+  fs.writeFileSync(path.join(root, 'stat'), 'cpu  1 0 1 1\nbtime 1600000000\n')
+
+  const spawn = pid => {
+    const dir = path.join(root, String(pid))
+
+    fs.mkdirSync(dir)
+    fs.writeFileSync(path.join(dir, 'stat'), `${pid} (fake) S 1 ${pid} ${pid} 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 100 0 0`)
+    fs.writeFileSync(path.join(dir, 'cmdline'), `fake${pid}\0`)
+  }
+
+  // two processes for each of 16 shards fill the cache
+  for (let pid = 17; pid <= 48; ++pid) {
+    spawn(pid)
+  }
+
+  const options = { procfs: root, metadataCache: 32 }
+  const read = () => ps.snapshot('pid', 'cmdline', options)
+
+  await read()
+  const first = ps.getStats().metadataCache
+
+  t.is(first.size, 32)
+
+  // new processes don't fit, they may be scanned before cached ones
+  for (let pid = 1; pid <= 16; ++pid) {
+    spawn(pid)
+  }
+
+  await read()
+  const second = ps.getStats().metadataCache
+
+  // every process cached by the first snapshot is hit by the second one
+  t.is(second.hits - first.hits, 32)
+  t.is(second.misses - first.misses, 16)
+  t.is(second.evictions, first.evictions)
+  t.is(second.size, 32)
+})
+
+test('metadata cache', async t => {
+  // `read` is builtin, so the shell execs without forking short-lived children
+  const child = require('child_process').spawn('sh', ['-c', 'read line; exec sleep 10'])
+  const options = { metadataCache: 1024, filter: { pids: [process.pid, child.pid] } }
+  const read = () => ps.snapshot('pid', 'name', 'path', 'cmdline', options)
+
+  const before = ps.getStats().metadataCache
+  const first = await read()
+  const second = await read()
+
+  t.deepEqual(second, first)
+  t.deepEqual(second, await ps.snapshot('pid', 'name', 'path', 'cmdline', { filter: options.filter }))
+
+  const counters = ps.getStats().metadataCache
+  t.true(counters.hits - before.hits >= 2)
+  t.true(counters.size >= 2)
+
+  // `execve` replaces the cached cmdline
+  child.stdin.write('\n')
+  await new Promise(resolve => setTimeout(resolve, 500))
+  const execed = (await read()).find(task => task.pid === child.pid)
+
+  // reap the child, so it doesn't vanish during scans of other tests
+  const exited = new Promise(resolve => child.once('exit', resolve))
+  child.kill()
+  await exited
+
+  t.is(execed.cmdline, 'sleep 10')
+  t.true(ps.getStats().metadataCache.invalidations > counters.invalidations)
+
+  t.throws(() => ps.snapshot('pid', { metadataCache: -1 }))
+})
@@ -0,0 +1,61 @@
+'use strict'
+
+import test from 'ava'
+import ps from '../'
+
+test('batches in pid order', async t => {
+  const pids = []
+
+  for await (const batch of ps.stream('pid', 'name', { batchSize: 4 })) {
+    t.true(batch.length > 0 && batch.length <= 4)
+    t.deepEqual(Object.keys(batch[0]), ['name', 'pid'])
+
+    pids.push(...batch.map(task => task.pid))
+  }
+
+  t.true(pids.includes(process.pid))
+  t.deepEqual(pids, pids.slice().sort((a, b) => a - b))
+  t.throws(() => ps.stream('pid', { stats: true }))
+})
+
+test('slow consumer and break', async t => {
+  let batches = 0
+
+  for await (const batch of ps.stream('pid', { batchSize: 1 })) {
+    t.is(batch.length, 1)
+    await new Promise(resolve => setTimeout(resolve, 10))
+
+    if (++batches === 3) {
+      break
+    }
+  }
+
+  t.is(batches, 3)
+  t.throws(() => ps.stream('pid', { batchSize: 0 }))
+})
+
+test('abandoned stream', async t => {
+  const batches = ps.stream('pid', { batchSize: 1, idleTimeout: 50 })
+
+  // the reader gives up instead of keeping the thread
+  await new Promise(resolve => setTimeout(resolve, 300))
+
+  const error = await t.throws((async () => {
+    for await (const batch of batches) {
+      t.is(batch.length, 1)
+    }
+  })())
+
+  t.true(/50 ms/.test(error.message))
+  t.throws(() => ps.stream('pid', { idleTimeout: 0 }))
+})
+
+test('dedicated executor', async t => {
+  let count = 0
+
+  for await (const batch of ps.stream('pid', { executor: 'dedicated' })) {
+    count += batch.length
+  }
+
+  t.true(count > 0)
+})
@@ -0,0 +1,53 @@
+'use strict'
+
+import test from 'ava'
+import ps from '../'
+
+test('depth-first order with totals', async t => {
+  const child = require('child_process').spawn('sleep', ['10'])
+  const tasks = await ps.tree('pid', 'name', { numeric: 'number' })
+
+  child.kill()
+  await new Promise(resolve => child.on('exit', resolve))
+
+  t.true(tasks.length > 0)
+
+  const self = tasks.findIndex(task => task.pid === process.pid)
+  const spawned = tasks[self + 1]
+
+  // the only child follows its parent
+  t.is(spawned.pid, child.pid)
+  t.is(spawned.depth, tasks[self].depth + 1)
+  t.is(spawned.subtree.count, 1)
+  t.is(spawned.subtree.pmem, spawned.pmem)
+  t.true(tasks[self].subtree.count >= 2)
+  t.true(tasks[self].subtree.pmem >= tasks[self].pmem + spawned.pmem)
+
+  const roots = tasks.filter(task => task.depth === 0)
+  const total = roots.reduce((sum, task) => sum + task.subtree.count, 0)
+  t.is(total, tasks.length)
+})
+
+test('roots only', async t => {
+  const tasks = await ps.tree('pid', { roots: true })
+
+  t.true(tasks.length > 0)
+  t.true(tasks.every(task => task.depth === 0))
+
+  // a filtered out parent makes a root
+  const self = await ps.tree('pid', { roots: true, filter: { pids: [process.pid] } })
+  t.is(self.length, 1)
+  t.is(self[0].subtree.count, 1)
+
+  t.throws(() => ps.tree('pid', { roots: 1 }))
+})
+
+test('tree stats', async t => {
+  const before = ps.getStats().snapshots
+  const tasks = await ps.tree('pid', { stats: true })
+
+  t.true(tasks.stats.processes > 0)
+  t.true(tasks.stats.phases.scan.wall > 0)
+  t.true(tasks.stats.phases.convert.wall > 0)
+  t.true(ps.getStats().snapshots > before)
+})
@@ -0,0 +1,75 @@
+'use strict'
+
+import test from 'ava'
+import ps from '../'
+
+// the proc connector requires CAP_NET_ADMIN
+function watcher (t) {
+  try {
+    return new ps.Watcher()
+  } catch (error) {
+    t.log(error.message)
+  }
+}
+
+test('fork, exec and exit events', async t => {
+  const w = watcher(t)
+
+  if (!w) {
+    return t.pass()
+  }
+
+  const before = await w.snapshot('pid', 'name')
+  t.truthy(before.find(task => task.pid === process.pid))
+
+  const events = []
+  const exited = new Promise(resolve => {
+    w.on('exit', event => event.pid === child.pid && resolve(event))
+  })
+
+  w.on('fork', event => events.push(['fork', event]))
+  w.on('exec', event => events.push(['exec', event]))
+
+  const child = require('child_process').spawn('sleep', ['0.2'])
+  const exit = await exited
+
+  t.is(exit.code, 0)
+  t.true(events.some(([type, event]) => type === 'fork' && event.pid === child.pid && event.ppid === process.pid))
+  t.true(events.some(([type, event]) => type === 'exec' && event.pid === child.pid))
+
+  const after = await w.snapshot('pid', 'name', 'pmem', { numeric: 'number' })
+  t.falsy(after.find(task => task.pid === child.pid))
+
+  const self = after.find(task => task.pid === process.pid)
+  t.true(self.pmem > 0)
+  t.throws(() => w.snapshot('pid', { procfs: '/tmp' }))
+
+  w.close()
+  await t.throws(w.snapshot('pid'))
+})
+
+test('table follows exec', async t => {
+  const w = watcher(t)
+
+  if (!w) {
+    return t.pass()
+  }
+
+  await w.snapshot('pid')
+
+  const child = require('child_process').spawn('sleep', ['10'])
+  await new Promise(resolve => {
+    w.on('exec', event => event.pid === child.pid && resolve())
+  })
+
+  const tasks = await w.snapshot('pid', 'name', 'cmdline', 'starttime', { filter: { pids: [child.pid] } })
+  const [read] = await ps.snapshot('pid', 'starttime', { filter: { pids: [child.pid] } })
+  child.kill()
+  await new Promise(resolve => child.on('exit', resolve))
+  w.close()
+
+  t.is(tasks.length, 1)
+  t.is(tasks[0].name, 'sleep')
+  t.is(tasks[0].cmdline, 'sleep 10')
+  t.is(+tasks[0].starttime, +read.starttime)
+})